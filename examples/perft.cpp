@@ -1,5 +1,8 @@
 #include <iostream>
+#include <string>
+#include <vector>
 #include "Board.h"
+#include "Magic.h"
 #include "MoveGenerator.h"
 #include "Perft.h"
 
@@ -7,19 +10,37 @@ int main(int argc, char* argv[]) {
     Board board;
     MoveGenerator gen;
 
-    if (argc > 1) {
-        if (!board.loadFEN(argv[1])) {
+    // --magic / --pext force the slider lookup backend so both can be
+    // timed on the same machine; the remaining arguments are positional.
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--magic" || arg == "--pext") {
+            auto backend = arg == "--pext" ? Magic::Backend::Pext : Magic::Backend::Magic;
+            if (!Magic::setBackend(backend)) {
+                std::cerr << "Slider backend " << Magic::backendName(backend)
+                          << " is not supported on this CPU" << std::endl;
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() > 0) {
+        if (!board.loadFEN(args[0])) {
             std::cerr << "Failed to load FEN" << std::endl;
             return 1;
         }
     }
 
     int depth = 1;
-    if (argc > 2) {
-        depth = std::stoi(argv[2]);
+    if (args.size() > 1) {
+        depth = std::stoi(args[1]);
     }
 
-    if (argc > 3 && std::string(argv[3]) == "divide") {
+    std::cout << "Slider backend: " << Magic::backendName(Magic::getBackend()) << "\n";
+    if (args.size() > 2 && args[2] == "divide") {
         uint64_t nodes = perftDivide(board, gen, depth);
         std::cout << "Perft divide total = " << nodes << "\n";
     } else {
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+// -----------------------------------------------------------------------------
+// Attack tables for the non-sliding pieces, generated at compile time and
+// shared by every board representation, move generator and the evaluator.
+// The tables live together in one cache-line aligned block so the lookups
+// made while generating moves for a node touch the same few lines.
+// -----------------------------------------------------------------------------
+namespace Attacks {
+
+struct alignas(64) LeaperTables {
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t pawn[2][64];  // [0] white, [1] black: squares a pawn captures on
+};
+
+// -----------------------------------------------------------------------------
+// Adds the square at (rank, file) to the mask when it lies on the board.
+// -----------------------------------------------------------------------------
+constexpr uint64_t squareIfOnBoard(int rank, int file) {
+    return (rank >= 0 && rank < 8 && file >= 0 && file < 8)
+               ? 1ULL << (rank * 8 + file)
+               : 0ULL;
+}
+
+// -----------------------------------------------------------------------------
+// Builds all leaper tables from rank/file offsets.
+// -----------------------------------------------------------------------------
+constexpr LeaperTables buildLeaperTables() {
+    LeaperTables t{};
+    constexpr int knightOffsets[8][2] = {{1, 2}, {2, 1}, {-1, 2}, {-2, 1},
+                                         {1, -2}, {2, -1}, {-1, -2}, {-2, -1}};
+    for (int sq = 0; sq < 64; ++sq) {
+        int rank = sq / 8;
+        int file = sq % 8;
+        for (const auto& o : knightOffsets)
+            t.knight[sq] |= squareIfOnBoard(rank + o[1], file + o[0]);
+        for (int dr = -1; dr <= 1; ++dr)
+            for (int df = -1; df <= 1; ++df)
+                if (dr != 0 || df != 0)
+                    t.king[sq] |= squareIfOnBoard(rank + dr, file + df);
+        t.pawn[0][sq] = squareIfOnBoard(rank + 1, file - 1) |
+                        squareIfOnBoard(rank + 1, file + 1);
+        t.pawn[1][sq] = squareIfOnBoard(rank - 1, file - 1) |
+                        squareIfOnBoard(rank - 1, file + 1);
+    }
+    return t;
+}
+
+inline constexpr LeaperTables leapers = buildLeaperTables();
+
+constexpr uint64_t knight(int sq) { return leapers.knight[sq]; }
+constexpr uint64_t king(int sq) { return leapers.king[sq]; }
+
+// Squares attacked by a pawn of the given colour (0 white, 1 black) on sq.
+// Indexing with the opposite colour gives the squares pawns attack sq from.
+constexpr uint64_t pawn(int color, int sq) { return leapers.pawn[color][sq]; }
+
+static_assert(leapers.knight[0] == 0x0000000000020400ULL, "knight table");
+static_assert(leapers.king[0] == 0x0000000000000302ULL, "king table");
+static_assert(leapers.pawn[0][8] == 0x0000000000020000ULL, "pawn table");
+
+} // namespace Attacks
@@ -1,8 +1,35 @@
 #include "BBCStyleEngine.h"
+#include "Attacks.h"
+#include "BitUtils.h"
+#include "Board.h"
+#include "EvalParams.h"
 #include "Magic.h"
+#include "Zobrist.h"
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
+// Castling rights that survive a move touching each square (BBC-style):
+// moving the king or a rook, or capturing on a rook square, clears them.
+static const int castlingRights[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11
+};
+
+// Zobrist terms of a set of castling rights
+static U64 castleKey(int rights) {
+    U64 key = 0ULL;
+    for (int i = 0; i < 4; ++i)
+        if (rights & (1 << i)) key ^= Zobrist::castleHash[i];
+    return key;
+}
+
 BBCStyleEngine::BBCStyleEngine() {
     stackIndex = 0;
     initializeBitboards();
@@ -16,28 +43,110 @@ void BBCStyleEngine::initializeBitboards() {
     side = white;
     enpassant = -1;  // No en passant
     castle = wk | wq | bk | bq;  // All castling rights
+    fifty = 0;
+    hashKey = 0ULL;
 }
 
-void BBCStyleEngine::loadFromFEN(const char* fen) {
+bool BBCStyleEngine::loadFromFEN(const char* fen) {
     initializeBitboards();
-    
-    // For simplicity, just set up starting position
-    // White pieces
-    bitboards[P] = 0x000000000000FF00ULL;  // White pawns
-    bitboards[N] = 0x0000000000000042ULL;  // White knights
-    bitboards[B] = 0x0000000000000024ULL;  // White bishops  
-    bitboards[R] = 0x0000000000000081ULL;  // White rooks
-    bitboards[Q] = 0x0000000000000008ULL;  // White queen
-    bitboards[K] = 0x0000000000000010ULL;  // White king
-    
-    // Black pieces
-    bitboards[p] = 0x00FF000000000000ULL;  // Black pawns
-    bitboards[n] = 0x4200000000000000ULL;  // Black knights
-    bitboards[b] = 0x2400000000000000ULL;  // Black bishops
-    bitboards[r] = 0x8100000000000000ULL;  // Black rooks
-    bitboards[q] = 0x0800000000000000ULL;  // Black queen
-    bitboards[k] = 0x1000000000000000ULL;  // Black king
-    
+    castle = 0;
+    if (!fen) return false;
+
+    // Piece placement, starting from a8
+    int rank = 7, file = 0;
+    const char* c = fen;
+    for (; *c && *c != ' '; ++c) {
+        if (*c == '/') {
+            --rank;
+            file = 0;
+            continue;
+        }
+        if (*c >= '1' && *c <= '8') {
+            file += *c - '0';
+            continue;
+        }
+        int piece = -1;
+        switch (*c) {
+            case 'P': piece = P; break;
+            case 'N': piece = N; break;
+            case 'B': piece = B; break;
+            case 'R': piece = R; break;
+            case 'Q': piece = Q; break;
+            case 'K': piece = K; break;
+            case 'p': piece = p; break;
+            case 'n': piece = n; break;
+            case 'b': piece = b; break;
+            case 'r': piece = r; break;
+            case 'q': piece = q; break;
+            case 'k': piece = k; break;
+        }
+        if (piece < 0 || rank < 0 || file > 7) return false;
+        set_bit(bitboards[piece], rank * 8 + file);
+        ++file;
+    }
+    updateOccupancies();
+    if (*c != ' ') return false;
+
+    // Side to move
+    ++c;
+    if (*c == 'w') side = white;
+    else if (*c == 'b') side = black;
+    else return false;
+    ++c;
+    while (*c == ' ') ++c;
+
+    // Castling rights
+    for (; *c && *c != ' '; ++c) {
+        switch (*c) {
+            case 'K': castle |= wk; break;
+            case 'Q': castle |= wq; break;
+            case 'k': castle |= bk; break;
+            case 'q': castle |= bq; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+    while (*c == ' ') ++c;
+
+    // En passant square
+    if (c[0] >= 'a' && c[0] <= 'h' && c[1] >= '1' && c[1] <= '8')
+        enpassant = (c[1] - '1') * 8 + (c[0] - 'a');
+    else if (c[0] != '-')
+        return false;
+
+    // Optional halfmove clock
+    while (*c && *c != ' ') ++c;
+    while (*c == ' ') ++c;
+    if (*c >= '0' && *c <= '9')
+        fifty = std::atoi(c);
+
+    hashKey = Zobrist::hashBoard(*this);
+    return true;
+}
+
+void BBCStyleEngine::loadFromBoard(const Board& board) {
+    // Direct bitboard copy: no FEN round trip and no allocation
+    bitboards[P] = board.getWhitePawns();
+    bitboards[N] = board.getWhiteKnights();
+    bitboards[B] = board.getWhiteBishops();
+    bitboards[R] = board.getWhiteRooks();
+    bitboards[Q] = board.getWhiteQueens();
+    bitboards[K] = board.getWhiteKing();
+    bitboards[p] = board.getBlackPawns();
+    bitboards[n] = board.getBlackKnights();
+    bitboards[b] = board.getBlackBishops();
+    bitboards[r] = board.getBlackRooks();
+    bitboards[q] = board.getBlackQueens();
+    bitboards[k] = board.getBlackKing();
+
+    side = board.isWhiteToMove() ? white : black;
+    enpassant = board.getEnPassantSquare();
+    castle = (board.canCastleWK() ? wk : 0) | (board.canCastleWQ() ? wq : 0) |
+             (board.canCastleBK() ? bk : 0) | (board.canCastleBQ() ? bq : 0);
+    fifty = board.getHalfmoveClock();
+    hashKey = board.key();
+    stackIndex = 0;
+
     updateOccupancies();
 }
 
@@ -68,6 +177,8 @@ void BBCStyleEngine::copyBoard() {
     state.side = side;
     state.enpassant = enpassant;
     state.castle = castle;
+    state.fifty = fifty;
+    state.hashKey = hashKey;
 }
 
 void BBCStyleEngine::takeBack() {
@@ -80,30 +191,35 @@ void BBCStyleEngine::takeBack() {
     side = state.side;
     enpassant = state.enpassant;
     castle = state.castle;
+    fifty = state.fifty;
+    hashKey = state.hashKey;
 }
 
 int BBCStyleEngine::makeMove(const Move& move) {
-    // BBC-style move application (simplified version)
     int source = move.source();
     int target = move.target();
     int piece = move.piece();
     int promoted = move.promoted();
     int capture = move.capture();
-    int castling = move.castling();
     
     // Move the piece (BBC-style direct bitboard manipulation)
     pop_bit(bitboards[piece], source);
     set_bit(bitboards[piece], target);
+    hashKey ^= Zobrist::pieceHashes[piece][source] ^ Zobrist::pieceHashes[piece][target];
+    
+    fifty++;
+    if (piece == P || piece == p) fifty = 0;
     
     // Handle captures
     if (capture) {
-        // Find and remove captured piece (BBC approach)
+        fifty = 0;
         int startPiece = (side == white) ? p : P;
         int endPiece = (side == white) ? k : K;
         
         for (int capturedPiece = startPiece; capturedPiece <= endPiece; capturedPiece++) {
             if (get_bit(bitboards[capturedPiece], target)) {
                 pop_bit(bitboards[capturedPiece], target);
+                hashKey ^= Zobrist::pieceHashes[capturedPiece][target];
                 break;
             }
         }
@@ -113,63 +229,90 @@ int BBCStyleEngine::makeMove(const Move& move) {
     if (promoted) {
         pop_bit(bitboards[piece], target);  // Remove pawn
         set_bit(bitboards[promoted], target);  // Add promoted piece
+        hashKey ^= Zobrist::pieceHashes[piece][target] ^ Zobrist::pieceHashes[promoted][target];
     }
     
-    // Handle castling (simplified)
-    if (castling) {
-        if (side == white) {
-            if (target == 6) {  // Kingside
-                pop_bit(bitboards[R], 7);
-                set_bit(bitboards[R], 5);
-            } else if (target == 2) {  // Queenside
-                pop_bit(bitboards[R], 0);
-                set_bit(bitboards[R], 3);
-            }
-        } else {
-            if (target == 62) {  // Kingside
-                pop_bit(bitboards[r], 63);
-                set_bit(bitboards[r], 61);
-            } else if (target == 58) {  // Queenside
-                pop_bit(bitboards[r], 56);
-                set_bit(bitboards[r], 59);
-            }
+    // En passant capture removes the pawn behind the target square
+    if (move.enpass()) {
+        int victim = side == white ? p : P;
+        int square = side == white ? target - 8 : target + 8;
+        pop_bit(bitboards[victim], square);
+        hashKey ^= Zobrist::pieceHashes[victim][square];
+    }
+    
+    // Like Board, the en passant square is only recorded when an enemy pawn
+    // stands next to the pushed pawn, so both boards hash identically
+    if (enpassant != -1) hashKey ^= Zobrist::enPassantHash[enpassant % 8];
+    enpassant = -1;
+    if (move.doublePush()) {
+        U64 enemyPawns = bitboards[side == white ? p : P];
+        U64 neighbours = 0ULL;
+        if (target % 8 > 0) neighbours |= 1ULL << (target - 1);
+        if (target % 8 < 7) neighbours |= 1ULL << (target + 1);
+        if (enemyPawns & neighbours) {
+            enpassant = side == white ? target - 8 : target + 8;
+            hashKey ^= Zobrist::enPassantHash[enpassant % 8];
+        }
+    }
+    
+    // Handle castling
+    if (move.castling()) {
+        int rook = side == white ? R : r;
+        int from = -1, to = -1;
+        switch (target) {
+            case 6:  from = 7;  to = 5;  break;
+            case 2:  from = 0;  to = 3;  break;
+            case 62: from = 63; to = 61; break;
+            case 58: from = 56; to = 59; break;
+        }
+        if (from != -1) {
+            pop_bit(bitboards[rook], from);
+            set_bit(bitboards[rook], to);
+            hashKey ^= Zobrist::pieceHashes[rook][from] ^ Zobrist::pieceHashes[rook][to];
         }
     }
     
-    // Update castling rights (simplified)
-    if (source == 4) castle &= ~(wk | wq);   // White king moved
-    if (source == 60) castle &= ~(bk | bq); // Black king moved
-    if (source == 0 || target == 0) castle &= ~wq;
-    if (source == 7 || target == 7) castle &= ~wk;
-    if (source == 56 || target == 56) castle &= ~bq;
-    if (source == 63 || target == 63) castle &= ~bk;
+    hashKey ^= castleKey(castle);
+    castle &= castlingRights[source];
+    castle &= castlingRights[target];
+    hashKey ^= castleKey(castle);
     
     // Update occupancies (BBC-style)
     updateOccupancies();
     
     // Change side
     side ^= 1;
+    hashKey ^= Zobrist::sideHash;
     
-    // Check if king is in check (BBC-style legality check)
-    int kingSquare = -1;
-    U64 kingBitboard = (side == white) ? bitboards[k] : bitboards[K];
-    
-    // Find king position (BBC-style bit scan)
-    for (int sq = 0; sq < 64; sq++) {
-        if (get_bit(kingBitboard, sq)) {
-            kingSquare = sq;
-            break;
-        }
-    }
-    
-    if (kingSquare != -1 && isSquareAttacked(kingSquare, side)) {
-        return 0;  // Illegal move - king in check
-    }
-    
-    return 1;  // Legal move
+    // Illegal if the side that just moved left its king in check
+    return isSquareAttacked(kingSquare(side ^ 1), side) ? 0 : 1;
+}
+
+// Flips the side to move and clears the en passant square. The halfmove clock
+// restarts as well, so that repetition detection never pairs a position with
+// one from before the null move.
+BBCStyleEngine::NullMoveState BBCStyleEngine::makeNullMove() {
+    NullMoveState state{enpassant, fifty, hashKey};
+    if (enpassant != -1) hashKey ^= Zobrist::enPassantHash[enpassant % 8];
+    enpassant = -1;
+    fifty = 0;
+    side ^= 1;
+    hashKey ^= Zobrist::sideHash;
+    return state;
+}
+
+void BBCStyleEngine::unmakeNullMove(const NullMoveState& state) {
+    side ^= 1;
+    enpassant = state.enpassant;
+    fifty = state.fifty;
+    hashKey = state.hashKey;
+}
+
+int BBCStyleEngine::kingSquare(int forSide) const {
+    return lsbIndex(bitboards[forSide == white ? K : k]);
 }
 
-bool BBCStyleEngine::isSquareAttacked(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttacked(int square, int bySide) const {
     // BBC-style ultra-fast attack checking
     return isSquareAttackedByPawn(square, bySide) ||
            isSquareAttackedByKnight(square, bySide) ||
@@ -179,68 +322,346 @@ bool BBCStyleEngine::isSquareAttacked(int square, int bySide) {
            isSquareAttackedByKing(square, bySide);
 }
 
-bool BBCStyleEngine::isSquareAttackedByPawn(int square, int bySide) {
-    int rank = square / 8;
-    int file = square % 8;
-    
-    if (bySide == white) {
-        if (rank > 0) {
-            if (file > 0 && get_bit(bitboards[P], (rank - 1) * 8 + file - 1)) return true;
-            if (file < 7 && get_bit(bitboards[P], (rank - 1) * 8 + file + 1)) return true;
+// -----------------------------------------------------------------------------
+// Pieces of both colours attacking the square through the given occupancy.
+// Pieces outside the occupancy are still reported and must be masked off.
+// -----------------------------------------------------------------------------
+U64 BBCStyleEngine::attackersTo(int square, U64 occupied) const {
+    const U64 bishopsQueens = bitboards[B] | bitboards[b] | bitboards[Q] | bitboards[q];
+    const U64 rooksQueens = bitboards[R] | bitboards[r] | bitboards[Q] | bitboards[q];
+    return (Attacks::pawn(black, square) & bitboards[P]) |
+           (Attacks::pawn(white, square) & bitboards[p]) |
+           (Attacks::knight(square) & (bitboards[N] | bitboards[n])) |
+           (Attacks::king(square) & (bitboards[K] | bitboards[k])) |
+           (Magic::getBishopAttacks(square, occupied) & bishopsQueens) |
+           (Magic::getRookAttacks(square, occupied) & rooksQueens);
+}
+
+namespace {
+// Material values used by the exchange evaluation, indexed by BBC piece
+const int seeValue[12] = {
+    EvalParams::PAWN_VALUE, EvalParams::KNIGHT_VALUE, EvalParams::BISHOP_VALUE,
+    EvalParams::ROOK_VALUE, EvalParams::QUEEN_VALUE, EvalParams::KING_VALUE,
+    EvalParams::PAWN_VALUE, EvalParams::KNIGHT_VALUE, EvalParams::BISHOP_VALUE,
+    EvalParams::ROOK_VALUE, EvalParams::QUEEN_VALUE, EvalParams::KING_VALUE};
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Static exchange evaluation: returns true when the exchange started by the
+// move on its target square wins at least `threshold` for the side to move.
+// Both sides recapture with their least valuable attacker and may stop when
+// continuing would lose material. Removing each capturer from the occupancy
+// uncovers the sliders behind it (x-rays). Pins are ignored; castling and
+// promotions count as an even exchange.
+// -----------------------------------------------------------------------------
+bool BBCStyleEngine::seeGE(const Move& move, int threshold) const {
+    if (move.castling() || move.promoted())
+        return 0 >= threshold;
+
+    const int from = move.source();
+    const int to = move.target();
+    int captured = 0;
+    U64 occupied = occupancies[both] ^ (1ULL << from);
+    if (move.enpass()) {
+        captured = EvalParams::PAWN_VALUE;
+        occupied ^= 1ULL << (to + (side == white ? -8 : 8));
+    } else if (get_bit(occupancies[side ^ 1], to)) {
+        const int first = side == white ? p : P;
+        for (int piece = first; piece < first + 6; ++piece)
+            if (get_bit(bitboards[piece], to)) {
+                captured = seeValue[piece];
+                break;
+            }
+    }
+
+    // swap is what the side to move stands to gain over the threshold, seen
+    // from the side that has just captured
+    int swap = captured - threshold;
+    if (swap < 0) return false;
+    swap = seeValue[move.piece()] - swap;
+    if (swap <= 0) return true;
+
+    const U64 bishopsQueens = bitboards[B] | bitboards[b] | bitboards[Q] | bitboards[q];
+    const U64 rooksQueens = bitboards[R] | bitboards[r] | bitboards[Q] | bitboards[q];
+    U64 attackers = attackersTo(to, occupied);
+    int stm = side;
+    bool result = true;
+    while (true) {
+        stm ^= 1;
+        attackers &= occupied;
+        U64 stmAttackers = attackers & occupancies[stm];
+        if (!stmAttackers) break;
+        result = !result;
+
+        // Least valuable attacker of the side to move
+        int type = P;
+        U64 candidates = 0;
+        for (; type <= K; ++type) {
+            candidates = stmAttackers & bitboards[type + (stm == white ? 0 : 6)];
+            if (candidates) break;
         }
-    } else {
-        if (rank < 7) {
-            if (file > 0 && get_bit(bitboards[p], (rank + 1) * 8 + file - 1)) return true;
-            if (file < 7 && get_bit(bitboards[p], (rank + 1) * 8 + file + 1)) return true;
+        if (type == K) {
+            // The king may only capture when the opponent has no attacker left
+            return (attackers & occupancies[stm ^ 1]) ? !result : result;
         }
+
+        swap = seeValue[type] - swap;
+        if (swap < static_cast<int>(result)) break;
+        occupied ^= candidates & (~candidates + 1);
+        if (type == P || type == B || type == Q)
+            attackers |= Magic::getBishopAttacks(to, occupied) & bishopsQueens;
+        if (type == R || type == Q)
+            attackers |= Magic::getRookAttacks(to, occupied) & rooksQueens;
     }
-    return false;
+    return result;
+}
+
+bool BBCStyleEngine::isSquareAttackedByPawn(int square, int bySide) const {
+    // A pawn attacks the square if a pawn of the other colour there would
+    // capture it
+    U64 pawns = bySide == white ? bitboards[P] : bitboards[p];
+    return pawns & Attacks::pawn(bySide ^ 1, square);
 }
 
-bool BBCStyleEngine::isSquareAttackedByKnight(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttackedByKnight(int square, int bySide) const {
     U64 knights = bySide == white ? bitboards[N] : bitboards[n];
-    return knights & Magic::getKnightAttacks(square);
+    return knights & Attacks::knight(square);
 }
 
-bool BBCStyleEngine::isSquareAttackedByBishop(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttackedByBishop(int square, int bySide) const {
     U64 bishops = bySide == white ? bitboards[B] : bitboards[b];
     return bishops & Magic::getBishopAttacks(square, occupancies[both]);
 }
 
-bool BBCStyleEngine::isSquareAttackedByRook(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttackedByRook(int square, int bySide) const {
     U64 rooks = bySide == white ? bitboards[R] : bitboards[r];
     return rooks & Magic::getRookAttacks(square, occupancies[both]);
 }
 
-bool BBCStyleEngine::isSquareAttackedByQueen(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttackedByQueen(int square, int bySide) const {
     U64 queens = bySide == white ? bitboards[Q] : bitboards[q];
     return queens & Magic::getQueenAttacks(square, occupancies[both]);
 }
 
-bool BBCStyleEngine::isSquareAttackedByKing(int square, int bySide) {
+bool BBCStyleEngine::isSquareAttackedByKing(int square, int bySide) const {
     U64 king = bySide == white ? bitboards[K] : bitboards[k];
-    return king & Magic::getKingAttacks(square);
+    return king & Attacks::king(square);
+}
+
+void BBCStyleEngine::generateMoves(MoveList& moveList) const {
+    moveList.count = 0;
+    generate(moveList, side, NOISY | QUIET);
 }
 
-void BBCStyleEngine::generateMoves(MoveList& moveList) {
-    // Simplified move generation for testing
-    // This is just a stub - full implementation would generate all moves
+void BBCStyleEngine::generateMoves(MoveList& moveList, int forSide) const {
     moveList.count = 0;
+    generate(moveList, forSide, NOISY | QUIET);
+}
+
+void BBCStyleEngine::generateCaptures(MoveList& moveList) const {
+    generate(moveList, side, NOISY);
+}
+
+void BBCStyleEngine::generateQuiets(MoveList& moveList) const {
+    generate(moveList, side, QUIET);
+}
+
+// -----------------------------------------------------------------------------
+// Appends the pseudo-legal moves of the requested kinds. Noisy moves are
+// captures, en passant and promotions to a queen; everything else, including
+// under-promotions without a capture and castling, is quiet.
+// -----------------------------------------------------------------------------
+void BBCStyleEngine::generate(MoveList& moveList, int forSide, int kinds) const {
+    const int enemy = forSide ^ 1;
+    const U64 enemies = occupancies[enemy];
+    const U64 empty = ~occupancies[both];
+    const bool noisy = kinds & NOISY;
+    const bool quiet = kinds & QUIET;
+    const U64 targetMask = (noisy ? enemies : 0ULL) | (quiet ? empty : 0ULL);
     
-    // For testing, just generate a few pawn moves
-    U64 pawns = (side == white) ? bitboards[P] : bitboards[p];
-    int direction = (side == white) ? 8 : -8;
-    int piece = (side == white) ? P : p;
+    auto addTargets = [&](int piece, int source, U64 targets) {
+        while (targets) {
+            int target = popLSBIndex(targets);
+            moveList.moves[moveList.count++] =
+                Move(source, target, piece, 0, get_bit(enemies, target) ? 1 : 0);
+        }
+    };
     
-    for (int square = 0; square < 64; square++) {
-        if (get_bit(pawns, square)) {
-            int target = square + direction;
-            if (target >= 0 && target < 64 && !get_bit(occupancies[both], target)) {
-                moveList.moves[moveList.count++] = Move(square, target, piece);
-                if (moveList.count >= 20) break; // Limit for testing
+    // Pawns: pushes, double pushes, captures, promotions and en passant
+    const int pawn = forSide == white ? P : p;
+    const int push = forSide == white ? 8 : -8;
+    const int startRank = forSide == white ? 1 : 6;
+    const int promoRank = forSide == white ? 6 : 1;
+    const int promos[4] = {forSide == white ? Q : q, forSide == white ? R : r,
+                           forSide == white ? B : b, forSide == white ? N : n};
+    U64 pawns = bitboards[pawn];
+    while (pawns) {
+        int source = popLSBIndex(pawns);
+        int rank = source / 8;
+        int file = source % 8;
+        int target = source + push;
+        
+        if (get_bit(empty, target)) {
+            if (rank == promoRank) {
+                for (int promo : promos)
+                    if (promo == promos[0] ? noisy : quiet)
+                        moveList.moves[moveList.count++] = Move(source, target, pawn, promo);
+            } else if (quiet) {
+                moveList.moves[moveList.count++] = Move(source, target, pawn);
+                if (rank == startRank && get_bit(empty, target + push))
+                    moveList.moves[moveList.count++] = Move(source, target + push, pawn, 0, 0, 1);
+            }
+        }
+        
+        if (!noisy) continue;
+        for (int df : {-1, 1}) {
+            if (file + df < 0 || file + df > 7) continue;
+            int captureSquare = target + df;
+            if (get_bit(enemies, captureSquare)) {
+                if (rank == promoRank) {
+                    for (int promo : promos)
+                        moveList.moves[moveList.count++] = Move(source, captureSquare, pawn, promo, 1);
+                } else {
+                    moveList.moves[moveList.count++] = Move(source, captureSquare, pawn, 0, 1);
+                }
+            } else if (captureSquare == enpassant && forSide == side) {
+                moveList.moves[moveList.count++] = Move(source, captureSquare, pawn, 0, 1, 0, 1);
             }
         }
     }
+    
+    // Knights
+    const int knight = forSide == white ? N : n;
+    U64 pieces = bitboards[knight];
+    while (pieces) {
+        int source = popLSBIndex(pieces);
+        addTargets(knight, source, Attacks::knight(source) & targetMask);
+    }
+    
+    // Bishops
+    const int bishop = forSide == white ? B : b;
+    pieces = bitboards[bishop];
+    while (pieces) {
+        int source = popLSBIndex(pieces);
+        addTargets(bishop, source, Magic::getBishopAttacks(source, occupancies[both]) & targetMask);
+    }
+    
+    // Rooks
+    const int rook = forSide == white ? R : r;
+    pieces = bitboards[rook];
+    while (pieces) {
+        int source = popLSBIndex(pieces);
+        addTargets(rook, source, Magic::getRookAttacks(source, occupancies[both]) & targetMask);
+    }
+    
+    // Queens
+    const int queen = forSide == white ? Q : q;
+    pieces = bitboards[queen];
+    while (pieces) {
+        int source = popLSBIndex(pieces);
+        addTargets(queen, source, Magic::getQueenAttacks(source, occupancies[both]) & targetMask);
+    }
+    
+    // King
+    const int king = forSide == white ? K : k;
+    if (!bitboards[king]) return;
+    int kingSq = lsbIndex(bitboards[king]);
+    addTargets(king, kingSq, Attacks::king(kingSq) & targetMask);
+    if (!quiet) return;
+    
+    // Castling: path must be empty and the king may not start on or cross an
+    // attacked square (the destination is checked by makeMove)
+    if (forSide == white) {
+        if ((castle & wk) && get_bit(empty, 5) && get_bit(empty, 6) &&
+            !isSquareAttacked(4, black) && !isSquareAttacked(5, black))
+            moveList.moves[moveList.count++] = Move(4, 6, K, 0, 0, 0, 0, 1);
+        if ((castle & wq) && get_bit(empty, 1) && get_bit(empty, 2) && get_bit(empty, 3) &&
+            !isSquareAttacked(4, black) && !isSquareAttacked(3, black))
+            moveList.moves[moveList.count++] = Move(4, 2, K, 0, 0, 0, 0, 1);
+    } else {
+        if ((castle & bk) && get_bit(empty, 61) && get_bit(empty, 62) &&
+            !isSquareAttacked(60, white) && !isSquareAttacked(61, white))
+            moveList.moves[moveList.count++] = Move(60, 62, k, 0, 0, 0, 0, 1);
+        if ((castle & bq) && get_bit(empty, 57) && get_bit(empty, 58) && get_bit(empty, 59) &&
+            !isSquareAttacked(60, white) && !isSquareAttacked(59, white))
+            moveList.moves[moveList.count++] = Move(60, 58, k, 0, 0, 0, 0, 1);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Checks that a move, typically taken from the transposition table or a
+// killer slot, is one generateMoves would produce in this position.
+// -----------------------------------------------------------------------------
+bool BBCStyleEngine::isPseudoLegal(const Move& move) const {
+    const int source = move.source();
+    const int target = move.target();
+    const int piece = move.piece();
+    const int first = side == white ? P : p;
+    if (piece < first || piece >= first + 6 || !get_bit(bitboards[piece], source))
+        return false;
+    if (get_bit(occupancies[side], target))
+        return false;
+    const bool enemyOnTarget = get_bit(occupancies[side ^ 1], target) != 0;
+    if (move.capture() != (enemyOnTarget || move.enpass()))
+        return false;
+    const int type = piece - first;
+    if (type != P && (move.promoted() || move.doublePush() || move.enpass()))
+        return false;
+    if (type != K && move.castling())
+        return false;
+
+    switch (type) {
+    case P: {
+        const int push = side == white ? 8 : -8;
+        const int lastRank = side == white ? 7 : 0;
+        const bool promotes = target / 8 == lastRank;
+        const int promo = move.promoted();
+        if (promotes != (promo != 0))
+            return false;
+        if (promo && (promo < first + N || promo > first + Q))
+            return false;
+        if (move.enpass())
+            return target == enpassant && !move.doublePush() &&
+                   (Attacks::pawn(side, source) & (1ULL << target));
+        if (move.capture())
+            return !move.doublePush() && (Attacks::pawn(side, source) & (1ULL << target));
+        if (get_bit(occupancies[both], source + push))
+            return false;
+        if (move.doublePush())
+            return source / 8 == (side == white ? 1 : 6) && target == source + 2 * push &&
+                   !get_bit(occupancies[both], target);
+        return target == source + push;
+    }
+    case N:
+        return Attacks::knight(source) & (1ULL << target);
+    case B:
+        return Magic::getBishopAttacks(source, occupancies[both]) & (1ULL << target);
+    case R:
+        return Magic::getRookAttacks(source, occupancies[both]) & (1ULL << target);
+    case Q:
+        return Magic::getQueenAttacks(source, occupancies[both]) & (1ULL << target);
+    default:
+        break;
+    }
+
+    if (!move.castling())
+        return Attacks::king(source) & (1ULL << target);
+    // Same conditions as the castling moves of generate()
+    const U64 occupied = occupancies[both];
+    const int enemy = side ^ 1;
+    if (side == white && source == 4 && target == 6)
+        return (castle & wk) && !(occupied & 0x60ULL) &&
+               !isSquareAttacked(4, enemy) && !isSquareAttacked(5, enemy);
+    if (side == white && source == 4 && target == 2)
+        return (castle & wq) && !(occupied & 0x0EULL) &&
+               !isSquareAttacked(4, enemy) && !isSquareAttacked(3, enemy);
+    if (side == black && source == 60 && target == 62)
+        return (castle & bk) && !(occupied & (0x60ULL << 56)) &&
+               !isSquareAttacked(60, enemy) && !isSquareAttacked(61, enemy);
+    if (side == black && source == 60 && target == 58)
+        return (castle & bq) && !(occupied & (0x0EULL << 56)) &&
+               !isSquareAttacked(60, enemy) && !isSquareAttacked(59, enemy);
+    return false;
 }
 
 uint64_t BBCStyleEngine::perft(int depth) {
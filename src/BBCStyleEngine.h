@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 
+class Board;
+
 // BBC-style direct bitboard manipulation for maximum performance
 // This is designed to match BBC's ultra-efficient approach
 
@@ -33,6 +35,8 @@ public:
     int side;
     int enpassant;
     int castle;
+    int fifty;   // Halfmove clock for the fifty-move rule
+    U64 hashKey; // Zobrist key, updated incrementally by makeMove
     
     // Board copy stack for fast make/unmake (BBC-style)
     struct BoardState {
@@ -41,13 +45,16 @@ public:
         int side;
         int enpassant; 
         int castle;
+        int fifty;
+        U64 hashKey;
     };
     
     BoardState boardStack[256];  // Pre-allocated stack
     int stackIndex;
     
     BBCStyleEngine();
-    void loadFromFEN(const char* fen);
+    bool loadFromFEN(const char* fen);       // Cold path: parse a FEN string
+    void loadFromBoard(const Board& board);  // Hot path: copy bitboards directly
     void copyBoard();     // BBC-style board copying
     void takeBack();      // BBC-style board restoration
     
@@ -81,24 +88,48 @@ public:
     };
     
     // BBC-style core functions
-    void generateMoves(MoveList& moveList);
+    // Pseudo-legal moves for the side to move (or for forSide); legality is
+    // decided by makeMove, which rejects moves leaving the king in check.
+    void generateMoves(MoveList& moveList) const;
+    void generateMoves(MoveList& moveList, int forSide) const;
+    // Staged generation for the side to move: both append to the list, and
+    // together they produce exactly the moves of generateMoves.
+    void generateCaptures(MoveList& moveList) const;  // captures, queen promotions
+    void generateQuiets(MoveList& moveList) const;    // everything else
+    bool isPseudoLegal(const Move& move) const;
     int makeMove(const Move& move);     // Returns 1 if legal, 0 if illegal
+    // Null move: passes the turn in place without a board copy. The returned
+    // state is all that changes and is handed back to unmakeNullMove.
+    struct NullMoveState {
+        int enpassant;
+        int fifty;
+        U64 hashKey;
+    };
+    NullMoveState makeNullMove();
+    void unmakeNullMove(const NullMoveState& state);
     void updateOccupancies();          // BBC-style occupancy update
-    bool isSquareAttacked(int square, int bySide);
+    bool isSquareAttacked(int square, int bySide) const;
+    int kingSquare(int forSide) const;
+    bool inCheck() const { return isSquareAttacked(kingSquare(side), side ^ 1); }
+    U64 attackersTo(int square, U64 occupied) const;
+    // True when the exchange the move starts gains at least threshold
+    bool seeGE(const Move& move, int threshold) const;
     
     // BBC-style ultra-fast perft
     uint64_t perft(int depth);
     uint64_t perftDivide(int depth);
     
 private:
+    enum { NOISY = 1, QUIET = 2 };
+    void generate(MoveList& moveList, int forSide, int kinds) const;
     void initializeBitboards();
     uint64_t perftRecursive(int depth);
     
     // BBC-style attack checking
-    bool isSquareAttackedByPawn(int square, int bySide);
-    bool isSquareAttackedByKnight(int square, int bySide);
-    bool isSquareAttackedByBishop(int square, int bySide);
-    bool isSquareAttackedByRook(int square, int bySide);
-    bool isSquareAttackedByQueen(int square, int bySide);
-    bool isSquareAttackedByKing(int square, int bySide);
+    bool isSquareAttackedByPawn(int square, int bySide) const;
+    bool isSquareAttackedByKnight(int square, int bySide) const;
+    bool isSquareAttackedByBishop(int square, int bySide) const;
+    bool isSquareAttackedByRook(int square, int bySide) const;
+    bool isSquareAttackedByQueen(int square, int bySide) const;
+    bool isSquareAttackedByKing(int square, int bySide) const;
 };
@@ -1,8 +1,11 @@
 #include "Board.h"
+#include "Attacks.h"
+#include "BitUtils.h"
 #include "Magic.h"
 #include "MoveEncoding.h"
 #include "MoveGenerator.h"
 #include "Zobrist.h"
+#include <algorithm>
 #include <array>
 #include <cctype>
 #include <cstdlib>
@@ -13,25 +16,29 @@ namespace {
 const int directions[8][2] = {{1, 0}, {-1, 0}, {0, 1},  {0, -1},
                               {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
 
-uint64_t knightAttacks(int sq) {
-  uint64_t p = 1ULL << sq;
-  uint64_t l1 = (p >> 1) & 0x7f7f7f7f7f7f7f7fULL;
-  uint64_t l2 = (p >> 2) & 0x3f3f3f3f3f3f3f3fULL;
-  uint64_t r1 = (p << 1) & 0xfefefefefefefefeULL;
-  uint64_t r2 = (p << 2) & 0xfcfcfcfcfcfcfcfcULL;
-  uint64_t h1 = l1 | r1;
-  uint64_t h2 = l2 | r2;
-  return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+// Squares strictly between a and b when they share a line, otherwise empty.
+uint64_t betweenMask(int a, int b) {
+  uint64_t ma = 1ULL << a;
+  uint64_t mb = 1ULL << b;
+  uint64_t rook = Magic::getRookAttacks(a, mb);
+  if (rook & mb)
+    return rook & Magic::getRookAttacks(b, ma);
+  uint64_t bishop = Magic::getBishopAttacks(a, mb);
+  if (bishop & mb)
+    return bishop & Magic::getBishopAttacks(b, ma);
+  return 0;
 }
 
-uint64_t kingAttacks(int sq) {
-  uint64_t p = 1ULL << sq;
-  uint64_t attacks = (p << 8) | (p >> 8);
-  uint64_t lr =
-      ((p << 1) & 0xfefefefefefefefeULL) | ((p >> 1) & 0x7f7f7f7f7f7f7f7fULL);
-  attacks |= lr;
-  attacks |= (lr << 8) | (lr >> 8);
-  return attacks;
+// The full line through two aligned squares, edge to edge.
+uint64_t lineMask(int a, int b) {
+  uint64_t ends = (1ULL << a) | (1ULL << b);
+  uint64_t rook = Magic::getRookAttacks(a, 0);
+  if (rook & (1ULL << b))
+    return (rook & Magic::getRookAttacks(b, 0)) | ends;
+  uint64_t bishop = Magic::getBishopAttacks(a, 0);
+  if (bishop & (1ULL << b))
+    return (bishop & Magic::getBishopAttacks(b, 0)) | ends;
+  return 0;
 }
 
 const std::array<int, 256 * 256> squareIndexLookup = [] {
@@ -68,34 +75,74 @@ void Board::clearBoard() {
   castleWK = castleWQ = castleBK = castleBQ = false;
   halfmoveClock = 0;
   fullmoveNumber = 1;
-  repetitionTable.clear();
+  keyHistorySize = 0;
   attackMaps[0] = attackMaps[1] = 0;
   squareAttacks.fill(0);
+  refreshKey();
+}
+
+//------------------------------------------------------------------------------
+// Recomputes the Zobrist key from scratch. Used after the position is set up
+// directly instead of through applyMove.
+//------------------------------------------------------------------------------
+void Board::refreshKey() { zobristKey = Zobrist::hashBoard(*this); }
+
+//------------------------------------------------------------------------------
+// Appends the current key to the key history. When the history is full only
+// the positions since the last irreversible move are kept.
+//------------------------------------------------------------------------------
+void Board::pushKey() {
+  if (keyHistorySize == KEY_HISTORY_SIZE) {
+    int keep = std::min(halfmoveClock, KEY_HISTORY_SIZE - 1);
+    std::copy(keyHistory.begin() + (keyHistorySize - keep),
+              keyHistory.begin() + keyHistorySize, keyHistory.begin());
+    keyHistorySize = keep;
+  }
+  keyHistory[keyHistorySize++] = zobristKey;
+}
+
+//------------------------------------------------------------------------------
+// Returns the Zobrist piece index (0-11, white pawn to black king) of the piece
+// on the given square, or -1 if the square is empty.
+//------------------------------------------------------------------------------
+int Board::pieceIndexAt(int square) const {
+  uint64_t mask = 1ULL << square;
+  const uint64_t pieces[12] = {whitePawns, whiteKnights, whiteBishops,
+                               whiteRooks, whiteQueens,  whiteKing,
+                               blackPawns, blackKnights, blackBishops,
+                               blackRooks, blackQueens,  blackKing};
+  for (int i = 0; i < 12; ++i)
+    if (pieces[i] & mask)
+      return i;
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+// Returns the part of the Zobrist key that depends on side to move, castling
+// rights and the en passant file.
+//------------------------------------------------------------------------------
+uint64_t Board::stateKey() const {
+  uint64_t h = 0;
+  if (whiteToMove) h ^= Zobrist::sideHash;
+  if (castleWK) h ^= Zobrist::castleHash[0];
+  if (castleWQ) h ^= Zobrist::castleHash[1];
+  if (castleBK) h ^= Zobrist::castleHash[2];
+  if (castleBQ) h ^= Zobrist::castleHash[3];
+  if (enPassantSquare != -1) h ^= Zobrist::enPassantHash[enPassantSquare % 8];
+  return h;
 }
 
 uint64_t Board::computeAttacks(int sq) const {
   uint64_t occ = getWhitePieces() | getBlackPieces();
   uint64_t mask = 1ULL << sq;
   if (whitePawns & mask)
-    return ((mask << 7) & 0x7F7F7F7F7F7F7F7FULL) |
-           ((mask << 9) & 0xFEFEFEFEFEFEFEFEULL);
+    return Attacks::pawn(0, sq);
   if (blackPawns & mask)
-    return ((mask >> 7) & 0xFEFEFEFEFEFEFEFEULL) |
-           ((mask >> 9) & 0x7F7F7F7F7F7F7F7FULL);
-
-  // Knight moves
-  if ((whiteKnights | blackKnights) & mask) {
-    const int offsets[8][2] = {{1, 2},  {2, 1},  {-1, 2},  {-2, 1},
-                               {1, -2}, {2, -1}, {-1, -2}, {-2, -1}};
-    int r = sq / 8, f = sq % 8;
-    uint64_t attacks = 0ULL;
-    for (auto &o : offsets) {
-      int tr = r + o[1], tf = f + o[0];
-      if (tr >= 0 && tr < 8 && tf >= 0 && tf < 8)
-        attacks |= 1ULL << (tr * 8 + tf);
-    }
-    return attacks;
-  }
+    return Attacks::pawn(1, sq);
+
+  // Knight
+  if ((whiteKnights | blackKnights) & mask)
+    return Attacks::knight(sq);
 
   // Bishop
   if ((whiteBishops | blackBishops) & mask)
@@ -110,20 +157,8 @@ uint64_t Board::computeAttacks(int sq) const {
     return Magic::getBishopAttacks(sq, occ) | Magic::getRookAttacks(sq, occ);
 
   // King
-  if ((whiteKing | blackKing) & mask) {
-    int r = sq / 8, f = sq % 8;
-    uint64_t attacks = 0ULL;
-    for (int dr = -1; dr <= 1; ++dr) {
-      for (int df = -1; df <= 1; ++df) {
-        if (dr == 0 && df == 0)
-          continue;
-        int tr = r + dr, tf = f + df;
-        if (tr >= 0 && tr < 8 && tf >= 0 && tf < 8)
-          attacks |= 1ULL << (tr * 8 + tf);
-      }
-    }
-    return attacks;
-  }
+  if ((whiteKing | blackKing) & mask)
+    return Attacks::king(sq);
 
   return 0ULL;
 }
@@ -153,11 +188,6 @@ void Board::updateLines(int sq) {
 }
 
 void Board::recalculateAttacks() {
-  static bool magicInit = false;
-  if (!magicInit) {
-    Magic::init();
-    magicInit = true;
-  }
   attackMaps[0] = attackMaps[1] = 0;
   squareAttacks.fill(0);
   uint64_t occ = getWhitePieces() | getBlackPieces();
@@ -302,8 +332,9 @@ bool Board::loadFEN(const std::string &fen) {
 
   halfmoveClock = half;
   fullmoveNumber = full;
-  repetitionTable.clear();
-  repetitionTable[Zobrist::hashBoard(*this)] = 1;
+  refreshKey();
+  keyHistorySize = 0;
+  pushKey();
   recalculateAttacks();
 
   return true;
@@ -409,7 +440,65 @@ bool Board::isMoveLegal(const std::string &move) const {
 }
 
 bool Board::isMoveLegal(uint16_t move) const {
-  MoveGenerator gen;
+  return isMoveLegal(move, legalityInfo());
+}
+
+//------------------------------------------------------------------------------
+// Bitboard of the pieces of one colour attacking a square, with sliders
+// blocked by the given occupancy.
+//------------------------------------------------------------------------------
+uint64_t Board::attackersTo(int square, uint64_t occupied, bool byWhite) const {
+  uint64_t pawns, knights, bishops, rooks, queens, king;
+  if (byWhite) {
+    pawns = whitePawns; knights = whiteKnights; bishops = whiteBishops;
+    rooks = whiteRooks; queens = whiteQueens; king = whiteKing;
+  } else {
+    pawns = blackPawns; knights = blackKnights; bishops = blackBishops;
+    rooks = blackRooks; queens = blackQueens; king = blackKing;
+  }
+  // A pawn attacks the square from where a pawn of the other colour on it
+  // would capture.
+  return (Attacks::pawn(byWhite ? 1 : 0, square) & pawns) |
+         (Attacks::knight(square) & knights) |
+         (Attacks::king(square) & king) |
+         (Magic::getBishopAttacks(square, occupied) & (bishops | queens)) |
+         (Magic::getRookAttacks(square, occupied) & (rooks | queens));
+}
+
+//------------------------------------------------------------------------------
+// Find the checkers and the pinned pieces of the side to move.
+//------------------------------------------------------------------------------
+Board::LegalityInfo Board::legalityInfo() const {
+  LegalityInfo info{0, 0, -1};
+  uint64_t king = whiteToMove ? whiteKing : blackKing;
+  if (!king)
+    return info;
+  int k = lsbIndex(king);
+  info.kingSquare = k;
+
+  uint64_t own = whiteToMove ? getWhitePieces() : getBlackPieces();
+  uint64_t occ = getWhitePieces() | getBlackPieces();
+  info.checkers = attackersTo(k, occ, !whiteToMove);
+
+  uint64_t straight = whiteToMove ? (blackRooks | blackQueens)
+                                  : (whiteRooks | whiteQueens);
+  uint64_t diagonal = whiteToMove ? (blackBishops | blackQueens)
+                                  : (whiteBishops | whiteQueens);
+  uint64_t snipers = (Magic::getRookAttacks(k, 0) & straight) |
+                     (Magic::getBishopAttacks(k, 0) & diagonal);
+  while (snipers) {
+    uint64_t blockers = betweenMask(k, popLSBIndex(snipers)) & occ;
+    if (blockers && !(blockers & (blockers - 1)) && (blockers & own))
+      info.pinned |= blockers;
+  }
+  return info;
+}
+
+//------------------------------------------------------------------------------
+// Check a move against precomputed pins and checks. The board is never copied
+// or modified, so callers can test every move of a position cheaply.
+//------------------------------------------------------------------------------
+bool Board::isMoveLegal(uint16_t move, const LegalityInfo &info) const {
   int from = moveFrom(move);
   int to = moveTo(move);
   int special = moveSpecial(move);
@@ -456,7 +545,7 @@ bool Board::isMoveLegal(uint16_t move) const {
       return false;
     }
   } else if ((whiteKnights & fromMask) || (blackKnights & fromMask)) {
-    if ((knightAttacks(from) & ~own & toMask))
+    if ((Attacks::knight(from) & ~own & toMask))
       pseudo = true;
     if (special != 0)
       return false;
@@ -478,7 +567,7 @@ bool Board::isMoveLegal(uint16_t move) const {
     if (special != 0)
       return false;
   } else if ((whiteKing & fromMask) || (blackKing & fromMask)) {
-    uint64_t attacks = kingAttacks(from) & ~own;
+    uint64_t attacks = Attacks::king(from) & ~own;
     if (attacks & toMask) {
       pseudo = true;
       if (special != 0)
@@ -487,28 +576,28 @@ bool Board::isMoveLegal(uint16_t move) const {
       if (isWhite) {
         if (from == 4 && to == 6 && castleWK &&
             !(occ & ((1ULL << 5) | (1ULL << 6))) &&
-            !gen.isSquareAttacked(*this, 4, false) &&
-            !gen.isSquareAttacked(*this, 5, false) &&
-            !gen.isSquareAttacked(*this, 6, false))
+            !attackersTo(4, occ, false) &&
+            !attackersTo(5, occ, false) &&
+            !attackersTo(6, occ, false))
           pseudo = true;
         else if (from == 4 && to == 2 && castleWQ &&
                  !(occ & ((1ULL << 1) | (1ULL << 2) | (1ULL << 3))) &&
-                 !gen.isSquareAttacked(*this, 4, false) &&
-                 !gen.isSquareAttacked(*this, 3, false) &&
-                 !gen.isSquareAttacked(*this, 2, false))
+                 !attackersTo(4, occ, false) &&
+                 !attackersTo(3, occ, false) &&
+                 !attackersTo(2, occ, false))
           pseudo = true;
       } else {
         if (from == 60 && to == 62 && castleBK &&
             !(occ & ((1ULL << 61) | (1ULL << 62))) &&
-            !gen.isSquareAttacked(*this, 60, true) &&
-            !gen.isSquareAttacked(*this, 61, true) &&
-            !gen.isSquareAttacked(*this, 62, true))
+            !attackersTo(60, occ, true) &&
+            !attackersTo(61, occ, true) &&
+            !attackersTo(62, occ, true))
           pseudo = true;
         else if (from == 60 && to == 58 && castleBQ &&
                  !(occ & ((1ULL << 57) | (1ULL << 58) | (1ULL << 59))) &&
-                 !gen.isSquareAttacked(*this, 60, true) &&
-                 !gen.isSquareAttacked(*this, 59, true) &&
-                 !gen.isSquareAttacked(*this, 58, true))
+                 !attackersTo(60, occ, true) &&
+                 !attackersTo(59, occ, true) &&
+                 !attackersTo(58, occ, true))
           pseudo = true;
       }
     }
@@ -519,9 +608,39 @@ bool Board::isMoveLegal(uint16_t move) const {
   if (!pseudo)
     return false;
 
-  Board copy = *this;
-  copy.applyMove(move);
-  return !gen.isKingInCheck(copy, !copy.isWhiteToMove());
+  int k = info.kingSquare;
+  if (k < 0)
+    return true;
+
+  if (from == k) {
+    // Castling squares were checked above; other king moves must not land
+    // on an attacked square once the king no longer blocks a slider.
+    return special == 3 || !attackersTo(to, occ ^ fromMask, !isWhite);
+  }
+
+  bool isPawn = (whitePawns | blackPawns) & fromMask;
+  if (isPawn && to == enPassantSquare && !(occ & toMask)) {
+    // En passant removes two pieces from the capture rank, so recompute
+    // the attacks on the king with the resulting occupancy.
+    uint64_t captured = 1ULL << (isWhite ? to - 8 : to + 8);
+    uint64_t after = (occ ^ fromMask ^ captured) | toMask;
+    return !(attackersTo(k, after, !isWhite) & ~captured);
+  }
+
+  if (info.checkers) {
+    // Double check leaves only king moves; a single check must be captured
+    // or blocked.
+    if (info.checkers & (info.checkers - 1))
+      return false;
+    uint64_t evasions =
+        info.checkers | betweenMask(k, lsbIndex(info.checkers));
+    if (!(evasions & toMask))
+      return false;
+  }
+
+  if ((info.pinned & fromMask) && !(lineMask(k, from) & toMask))
+    return false;
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -565,19 +684,15 @@ void Board::makeMove(uint16_t move, MoveState &state) {
   state.whiteAttacks = attackMaps[0];
   state.blackAttacks = attackMaps[1];
   state.squareAttacks = squareAttacks;
+  state.zobristKey = zobristKey;
 
   applyMove(move);
-  state.zobristKey = Zobrist::hashBoard(*this);
 }
 
 void Board::unmakeMove(const MoveState &state) {
-  // Decrement count for the current position before restoring the previous one
-  uint64_t currentKey = Zobrist::hashBoard(*this);
-  auto it = repetitionTable.find(currentKey);
-  if (it != repetitionTable.end()) {
-    if (--it->second == 0)
-      repetitionTable.erase(it);
-  }
+  // Drop the current position from the history before restoring the previous one
+  if (keyHistorySize > 0)
+    --keyHistorySize;
 
   whitePawns = state.whitePawns;
   whiteKnights = state.whiteKnights;
@@ -602,6 +717,7 @@ void Board::unmakeMove(const MoveState &state) {
   attackMaps[0] = state.whiteAttacks;
   attackMaps[1] = state.blackAttacks;
   squareAttacks = state.squareAttacks;
+  zobristKey = state.zobristKey;
 }
 
 //------------------------------------------------------------------------------
@@ -640,14 +756,27 @@ void Board::applyMove(uint16_t move) {
   bool capture = ((getWhitePieces() | getBlackPieces()) & toMask);
   bool pawnMove = (whitePawns & fromMask) || (blackPawns & fromMask);
 
+  // Take out the side, castling and en passant terms; they are added back
+  // for the new state at the end of the move
+  zobristKey ^= stateKey();
+  int movingPiece = pieceIndexAt(from);
+  int capturedPiece = pieceIndexAt(to);
+  if (capturedPiece >= 0)
+    zobristKey ^= Zobrist::pieceHashes[capturedPiece][to];
+  if (movingPiece >= 0)
+    zobristKey ^= Zobrist::pieceHashes[movingPiece][from] ^
+                  Zobrist::pieceHashes[movingPiece][to];
+
   int prevEnPassant = enPassantSquare;
   bool enPassantCapture = pawnMove && to == prevEnPassant && !capture;
   if (enPassantCapture) {
-    uint64_t capMask = whiteToMove ? (1ULL << (to - 8)) : (1ULL << (to + 8));
+    int capSquare = whiteToMove ? to - 8 : to + 8;
+    uint64_t capMask = 1ULL << capSquare;
     if (whiteToMove)
       blackPawns &= ~capMask;
     else
       whitePawns &= ~capMask;
+    zobristKey ^= Zobrist::pieceHashes[whiteToMove ? 6 : 0][capSquare];
     capture = true;
   }
 
@@ -709,6 +838,8 @@ void Board::applyMove(uint16_t move) {
         movePiece(blackPawns) || movePiece(blackKnights) ||
         movePiece(blackBishops) || movePiece(blackRooks) ||
         movePiece(blackQueens) || movePiece(blackKing))) {
+    refreshKey();
+    pushKey();
     return;
   }
 
@@ -719,6 +850,7 @@ void Board::applyMove(uint16_t move) {
       squareAttacks[7] = 0;
       whiteRooks &= ~(1ULL << 7);
       whiteRooks |= (1ULL << 5);
+      zobristKey ^= Zobrist::pieceHashes[3][7] ^ Zobrist::pieceHashes[3][5];
       squareAttacks[5] = computeAttacks(5);
       attackMaps[0] |= squareAttacks[5];
       updateLines(7);
@@ -728,6 +860,7 @@ void Board::applyMove(uint16_t move) {
       squareAttacks[0] = 0;
       whiteRooks &= ~(1ULL << 0);
       whiteRooks |= (1ULL << 3);
+      zobristKey ^= Zobrist::pieceHashes[3][0] ^ Zobrist::pieceHashes[3][3];
       squareAttacks[3] = computeAttacks(3);
       attackMaps[0] |= squareAttacks[3];
       updateLines(0);
@@ -741,6 +874,7 @@ void Board::applyMove(uint16_t move) {
       squareAttacks[63] = 0;
       blackRooks &= ~(1ULL << 63);
       blackRooks |= (1ULL << 61);
+      zobristKey ^= Zobrist::pieceHashes[9][63] ^ Zobrist::pieceHashes[9][61];
       squareAttacks[61] = computeAttacks(61);
       attackMaps[1] |= squareAttacks[61];
       updateLines(63);
@@ -750,6 +884,7 @@ void Board::applyMove(uint16_t move) {
       squareAttacks[56] = 0;
       blackRooks &= ~(1ULL << 56);
       blackRooks |= (1ULL << 59);
+      zobristKey ^= Zobrist::pieceHashes[9][56] ^ Zobrist::pieceHashes[9][59];
       squareAttacks[59] = computeAttacks(59);
       attackMaps[1] |= squareAttacks[59];
       updateLines(56);
@@ -771,6 +906,13 @@ void Board::applyMove(uint16_t move) {
   }
 
   if (promoChar && pawnMove) {
+    int pawnIndex = whiteToMove ? 0 : 6;
+    int promoIndex = pawnIndex + (promoChar == 'n'   ? 1
+                                  : promoChar == 'b' ? 2
+                                  : promoChar == 'r' ? 3
+                                                     : 4);
+    zobristKey ^= Zobrist::pieceHashes[pawnIndex][to] ^
+                  Zobrist::pieceHashes[promoIndex][to];
     if (whiteToMove) {
       whitePawns &= ~toMask;
       switch (promoChar) {
@@ -834,46 +976,52 @@ void Board::applyMove(uint16_t move) {
   if (!whiteToMove)
     ++fullmoveNumber;
 
-  uint64_t key = Zobrist::hashBoard(*this);
-  repetitionTable[key]++;
+  zobristKey ^= stateKey();
+  pushKey();
 }
 
 //------------------------------------------------------------------------------
 // Determine whether the current position has occurred three or more times.
 //------------------------------------------------------------------------------
-bool Board::isThreefoldRepetition() const {
-  uint64_t key = Zobrist::hashBoard(*this);
-  auto it = repetitionTable.find(key);
-  return it != repetitionTable.end() && it->second >= 3;
-}
+bool Board::isThreefoldRepetition() const { return repetitionCount() >= 3; }
 
 //------------------------------------------------------------------------------
 // Get how many times the current position has appeared in the game history.
 //------------------------------------------------------------------------------
 int Board::repetitionCount() const {
-  uint64_t key = Zobrist::hashBoard(*this);
-  auto it = repetitionTable.find(key);
-  return it != repetitionTable.end() ? it->second : 0;
+  // Only positions with the same side to move since the last irreversible
+  // move can match, so the scan steps back two plies at a time.
+  int count = 1;
+  int current = keyHistorySize - 1;
+  int oldest = std::max(0, current - halfmoveClock);
+  for (int i = current - 2; i >= oldest; i -= 2)
+    if (keyHistory[i] == zobristKey)
+      ++count;
+  return count;
 }
 
 //------------------------------------------------------------------------------
 // Check whether the side to move has no legal moves and is not in check.
 //------------------------------------------------------------------------------
 bool Board::isStalemate() const {
-  MoveGenerator gen;
-  if (gen.isKingInCheck(*this, whiteToMove))
+  LegalityInfo info = legalityInfo();
+  if (info.checkers)
     return false;
-  auto moves = gen.generateLegalMoves(*this, whiteToMove);
-  return moves.empty();
+  MoveGenerator gen;
+  auto moves = gen.generateAllMoves(*this, whiteToMove);
+  return std::none_of(moves.begin(), moves.end(),
+                      [&](uint16_t m) { return isMoveLegal(m, info); });
 }
 
 //------------------------------------------------------------------------------
 // Check whether the side to move is in check and has no legal moves.
 //------------------------------------------------------------------------------
 bool Board::isCheckmate() const {
-  MoveGenerator gen;
-  if (!gen.isKingInCheck(*this, whiteToMove))
+  LegalityInfo info = legalityInfo();
+  if (!info.checkers)
     return false;
-  auto moves = gen.generateLegalMoves(*this, whiteToMove);
-  return moves.empty();
+  MoveGenerator gen;
+  auto moves = gen.generateAllMoves(*this, whiteToMove);
+  return std::none_of(moves.begin(), moves.end(),
+                      [&](uint16_t m) { return isMoveLegal(m, info); });
 }
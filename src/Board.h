@@ -1,10 +1,14 @@
 #pragma once
 #include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <array>
 
 class Board {
+public:
+    // Capacity of the key history. Positions before the last irreversible
+    // move can never repeat, so older entries are dropped when it fills up.
+    static constexpr int KEY_HISTORY_SIZE = 256;
+
 private:
     uint64_t whitePawns, whiteKnights, whiteBishops, whiteRooks, whiteQueens, whiteKing;
     uint64_t blackPawns, blackKnights, blackBishops, blackRooks, blackQueens, blackKing;
@@ -13,13 +17,20 @@ private:
     bool castleWK, castleWQ, castleBK, castleBQ;
     int halfmoveClock;
     int fullmoveNumber;
-    std::unordered_map<uint64_t,int> repetitionTable;
+    uint64_t zobristKey;               // Maintained incrementally by applyMove
+    std::array<uint64_t,KEY_HISTORY_SIZE> keyHistory; // Keys of the game so far, current last
+    int keyHistorySize;
     uint64_t attackMaps[2];            // Aggregated attack bitboards for white and black
     std::array<uint64_t,64> squareAttacks; // Attack bitboard from each occupied square
 
     uint64_t computeAttacks(int square) const;
     void updateLines(int square);
     void recalculateAttacks();
+    void refreshKey();
+    int pieceIndexAt(int square) const;
+    uint64_t stateKey() const;
+    void pushKey();
+    uint64_t attackersTo(int square, uint64_t occupied, bool byWhite) const;
 
 public:
     Board();
@@ -36,7 +47,15 @@ public:
         int fullmoveNumber;
         uint64_t whiteAttacks, blackAttacks;
         std::array<uint64_t,64> squareAttacks;
-        uint64_t zobristKey;  // Hash of the position after the move
+        uint64_t zobristKey;  // Hash of the position before the move
+    };
+
+    // Pins and checks against the side to move. Computed once per position
+    // so that each candidate move can be checked with a few bit operations.
+    struct LegalityInfo {
+        uint64_t pinned;    // Own pieces pinned to the king
+        uint64_t checkers;  // Enemy pieces giving check
+        int kingSquare;     // -1 when the side to move has no king
     };
 
     enum class Color { None, White, Black };
@@ -47,11 +66,11 @@ public:
     bool canCastleWQ() const { return castleWQ; }
     bool canCastleBK() const { return castleBK; }
     bool canCastleBQ() const { return castleBQ; }
-    void setWhiteToMove(bool v) { whiteToMove = v; }
-    void setCastleWK(bool v) { castleWK = v; }
-    void setCastleWQ(bool v) { castleWQ = v; }
-    void setCastleBK(bool v) { castleBK = v; }
-    void setCastleBQ(bool v) { castleBQ = v; }
+    void setWhiteToMove(bool v) { whiteToMove = v; refreshKey(); }
+    void setCastleWK(bool v) { castleWK = v; refreshKey(); }
+    void setCastleWQ(bool v) { castleWQ = v; refreshKey(); }
+    void setCastleBK(bool v) { castleBK = v; refreshKey(); }
+    void setCastleBQ(bool v) { castleBQ = v; refreshKey(); }
 
     // Getters for testing and internal logic
     uint64_t getWhitePawns() const { return whitePawns; }
@@ -74,6 +93,9 @@ public:
     uint64_t getBlackAttacks() const { return attackMaps[1]; }
     int getHalfmoveClock() const { return halfmoveClock; }
     int getFullmoveNumber() const { return fullmoveNumber; }
+    uint64_t key() const { return zobristKey; }
+    const uint64_t* getKeyHistory() const { return keyHistory.data(); }
+    int getKeyHistorySize() const { return keyHistorySize; }
     bool isFiftyMoveDraw() const { return halfmoveClock >= 100; }
     bool isThreefoldRepetition() const;
     int repetitionCount() const;
@@ -81,19 +103,19 @@ public:
     bool isCheckmate() const;
 
     // Setters for testing
-    void setWhitePawns(uint64_t value) { whitePawns = value; }
-    void setBlackPawns(uint64_t value) { blackPawns = value; }
-    void setWhiteKing(uint64_t value) { whiteKing = value; }
-    void setBlackKing(uint64_t value) { blackKing = value; }
-    void setWhiteRooks(uint64_t value) { whiteRooks = value; }
-    void setBlackRooks(uint64_t value) { blackRooks = value; }
-    void setWhiteBishops(uint64_t value) { whiteBishops = value; }
-    void setBlackBishops(uint64_t value) { blackBishops = value; }
-    void setWhiteQueens(uint64_t value) { whiteQueens = value; }
-    void setBlackQueens(uint64_t value) { blackQueens = value; }
-    void setWhiteKnights(uint64_t value) { whiteKnights = value; }
-    void setBlackKnights(uint64_t value) { blackKnights = value; }
-    void setEnPassantSquare(int square) { enPassantSquare = square; }
+    void setWhitePawns(uint64_t value) { whitePawns = value; refreshKey(); }
+    void setBlackPawns(uint64_t value) { blackPawns = value; refreshKey(); }
+    void setWhiteKing(uint64_t value) { whiteKing = value; refreshKey(); }
+    void setBlackKing(uint64_t value) { blackKing = value; refreshKey(); }
+    void setWhiteRooks(uint64_t value) { whiteRooks = value; refreshKey(); }
+    void setBlackRooks(uint64_t value) { blackRooks = value; refreshKey(); }
+    void setWhiteBishops(uint64_t value) { whiteBishops = value; refreshKey(); }
+    void setBlackBishops(uint64_t value) { blackBishops = value; refreshKey(); }
+    void setWhiteQueens(uint64_t value) { whiteQueens = value; refreshKey(); }
+    void setBlackQueens(uint64_t value) { blackQueens = value; refreshKey(); }
+    void setWhiteKnights(uint64_t value) { whiteKnights = value; refreshKey(); }
+    void setBlackKnights(uint64_t value) { blackKnights = value; refreshKey(); }
+    void setEnPassantSquare(int square) { enPassantSquare = square; refreshKey(); }
 
     void clearBoard();  // Utility function to reset the board state
     void printBoard() const;
@@ -101,6 +123,8 @@ public:
     std::string getFEN() const;
     bool isMoveLegal(const std::string& move) const;
     bool isMoveLegal(uint16_t move) const;
+    bool isMoveLegal(uint16_t move, const LegalityInfo& info) const;
+    LegalityInfo legalityInfo() const;
     void makeMove(const std::string& move);
     void makeMove(const std::string& move, MoveState& state);
     void makeMove(uint16_t move);
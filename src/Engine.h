@@ -1,34 +1,38 @@
 #pragma once
 #include "Board.h"
 #include "BBCStyleEngine.h"
+#include "SearchContext.h"
+#include "SearchScore.h"
 #include "TranspositionTable.h"
 #include "Zobrist.h"
 #include "OpeningBook.h"
 #include "Tablebase.h"
 #include "ThreadPool.h"
+#include <algorithm>
+#include <array>
 #include <string>
 #include <chrono>
 #include <atomic>
 #include <utility>
 #include <unordered_map>
+#include <vector>
+#include <memory>
 
 class Engine {
 public:
-    Engine();
     enum class GamePhase { Opening, Middlegame, Endgame };
 
     GamePhase getGamePhase(const Board& board) const;
     int evaluate(const Board& board) const;
-    std::pair<int, std::string>
-    minimax(Board& board, int depth, int alpha, int beta, bool maximizing,
-            const std::chrono::steady_clock::time_point& end,
-            const std::atomic<bool>& stop, int ply = 0);
+    int evaluate(const BBCStyleEngine& position) const;
+    static constexpr int MATE = SearchScore::MATE;
+    static constexpr int MATE_BOUND = SearchScore::MATE_BOUND;
 
-    // Simple negamax search with alpha-beta pruning
-    int negamaxAlphaBeta(Board& board, int depth,
-                         int alpha, int beta, int color,
-                         const std::chrono::steady_clock::time_point& end,
-                         const std::atomic<bool>& stop);
+    // Searches the position held by ctx.bbc and returns the score for the
+    // side to move; the principal variation is left in ctx.pv[ply]
+    int negamax(SearchContext& ctx, int depth, int alpha, int beta,
+                const std::chrono::steady_clock::time_point& end,
+                const std::atomic<bool>& stop, int ply = 0);
 
     std::string searchBestMove(Board& board, int depth);
 
@@ -36,21 +40,81 @@ public:
                                     int timeLimitMs,
                                     std::atomic<bool>& stopFlag);
 
-    void clearTranspositionTable() { tt.clear(); }
+    void clearTranspositionTable() { tt.clear(&pool, searchThreads); }
     void setHashSizeMB(size_t mb);
     size_t getHashSize() const { return tt.size(); }
+    bool saveHash(const std::string& path) const { return tt.save(path); }
+    bool loadHash(const std::string& path) { return tt.load(path); }
     void setOwnBook(bool enabled) { useOwnBook = enabled; }
     bool isOwnBookEnabled() const { return useOwnBook; }
+    // Search threads: the calling thread plus helpers from the pool, so the
+    // pool size bounds the count
+    void setThreads(int count) { searchThreads = std::max(1, std::min(count, getMaxThreads())); }
+    int getThreads() const { return searchThreads; }
+    int getMaxThreads() const { return static_cast<int>(pool.size()) + 1; }
+    void setTTPrefetch(bool enabled) { ttPrefetch = enabled; }
+    bool isTTPrefetchEnabled() const { return ttPrefetch; }
+
+    // Forward pruning driven by the static evaluation, each switchable on its
+    // own so that its effect can be measured
+    struct PruningOptions {
+        bool reverseFutility = true;
+        bool futility = true;
+        bool razoring = true;
+        bool lateMovePruning = true;
+    };
+    void setPruning(const PruningOptions& options) { pruning = options; }
+    const PruningOptions& getPruning() const { return pruning; }
+
+    // Totals of a fixed-depth search over the bench positions
+    struct BenchResult {
+        uint64_t nodes = 0;
+        double ms = 0.0;
+        // Wall-clock time per node in time stamp counter ticks (nanoseconds
+        // without a TSC); memory stalls show up as a higher figure
+        double ticksPerNode = 0.0;
+        uint64_t failHighs = 0;      // aspiration re-searches
+        uint64_t failLows = 0;
+    };
+    BenchResult bench(int depth);
 
 private:
-    int quiescence(Board& board, int alpha, int beta, bool maximizing,
+    // Result of one root iteration performed by a single search thread
+    struct RootResult {
+        BBCStyleEngine::Move move;
+        int score = 0;  // for the side to move at the root
+        std::array<uint16_t, SearchContext::MAX_PLY> pv{};
+        int pvLength = 0;
+        bool complete = false;
+    };
+
+    std::vector<BBCStyleEngine::Move> generateRootMoves(SearchContext& ctx);
+    RootResult searchRoot(SearchContext& ctx,
+                          const std::vector<BBCStyleEngine::Move>& moves,
+                          int depth, int alpha, int beta,
+                          const std::chrono::steady_clock::time_point& end,
+                          const std::atomic<bool>& stop);
+    RootResult aspirationSearch(SearchContext& ctx,
+                                const std::vector<BBCStyleEngine::Move>& moves,
+                                int depth, int previousScore,
+                                const std::chrono::steady_clock::time_point& end,
+                                const std::atomic<bool>& stop);
+    uint16_t lazySmpSearch(Board& board, int maxDepth,
+                           const std::chrono::steady_clock::time_point& end,
+                           const std::atomic<bool>& stop, bool printInfo);
+    void prepareSearchContexts(int count);
+    uint64_t totalNodes() const;
+    std::pair<uint64_t, uint64_t> totalResearches() const;  // fail highs, fail lows
+    int quiescence(SearchContext& ctx, int alpha, int beta,
                    const std::chrono::steady_clock::time_point& end,
-                   const std::atomic<bool>& stop);
-    BBCStyleEngine bbcEngine;  // Ultra-fast BBC-style engine
-    std::atomic<uint64_t> nodes = 0;
+                   const std::atomic<bool>& stop, int ply);
+    std::vector<std::unique_ptr<SearchContext>> contexts; // one per search thread
     TranspositionTable tt;
     OpeningBook book;
     Tablebase tablebase;
     ThreadPool pool;
+    int searchThreads = 1;
     bool useOwnBook = false;
+    bool ttPrefetch = true;  // prefetch the child's TT cluster before recursing
+    PruningOptions pruning;
 };
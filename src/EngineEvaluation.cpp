@@ -1,3 +1,4 @@
+#include "Attacks.h"
 #include "BitUtils.h"
 #include "Engine.h"
 #include "EvalParams.h"
@@ -7,8 +8,8 @@
 // Determines the phase of the game (opening, middlegame, endgame) based on the
 // total number of pieces remaining on the board.
 // -----------------------------------------------------------------------------
-Engine::GamePhase Engine::getGamePhase(const Board &b) const {
-  uint64_t all = b.getWhitePieces() | b.getBlackPieces();
+static Engine::GamePhase phaseFromOccupancy(uint64_t all) {
+  using GamePhase = Engine::GamePhase;
   int pieces = popcount64(all);
   if (pieces > EvalParams::GAME_PHASE_OPENING_THRESHOLD)
     return GamePhase::Opening;
@@ -17,38 +18,61 @@ Engine::GamePhase Engine::getGamePhase(const Board &b) const {
   return GamePhase::Endgame;
 }
 
+Engine::GamePhase Engine::getGamePhase(const Board &b) const {
+  return phaseFromOccupancy(b.getWhitePieces() | b.getBlackPieces());
+}
+
 // -----------------------------------------------------------------------------
 // Returns the mirrored square index relative to the horizontal center of the
 // board. Useful for evaluating black piece positions using white tables.
 // -----------------------------------------------------------------------------
 static int mirror(int sq) { return ((7 - (sq / 8)) * 8) + (sq % 8); }
 
+namespace {
 // -----------------------------------------------------------------------------
-// Generates a bitboard mask of all squares attacked by a king placed on the
-// given square.
+// Read-only view giving a BBC-style board the Board accessors used by the
+// evaluation terms below.
 // -----------------------------------------------------------------------------
-static uint64_t kingAttackMask(int sq) {
-  int r = sq / 8, f = sq % 8;
-  uint64_t mask = 0;
-  for (int dr = -1; dr <= 1; ++dr) {
-    for (int df = -1; df <= 1; ++df) {
-      if (dr == 0 && df == 0)
-        continue;
-      int tr = r + dr, tf = f + df;
-      if (tr >= 0 && tr < 8 && tf >= 0 && tf < 8)
-        mask |= 1ULL << (tr * 8 + tf);
-    }
-  }
-  return mask;
+struct BBCBoardView {
+  const BBCStyleEngine &e;
+  uint64_t getWhitePawns() const { return e.bitboards[P]; }
+  uint64_t getWhiteKnights() const { return e.bitboards[N]; }
+  uint64_t getWhiteBishops() const { return e.bitboards[B]; }
+  uint64_t getWhiteRooks() const { return e.bitboards[R]; }
+  uint64_t getWhiteQueens() const { return e.bitboards[Q]; }
+  uint64_t getWhiteKing() const { return e.bitboards[K]; }
+  uint64_t getBlackPawns() const { return e.bitboards[p]; }
+  uint64_t getBlackKnights() const { return e.bitboards[n]; }
+  uint64_t getBlackBishops() const { return e.bitboards[b]; }
+  uint64_t getBlackRooks() const { return e.bitboards[r]; }
+  uint64_t getBlackQueens() const { return e.bitboards[q]; }
+  uint64_t getBlackKing() const { return e.bitboards[k]; }
+  bool isWhiteToMove() const { return e.side == white; }
+  bool canCastleWK() const { return e.castle & wk; }
+  bool canCastleWQ() const { return e.castle & wq; }
+  bool canCastleBK() const { return e.castle & bk; }
+  bool canCastleBQ() const { return e.castle & bq; }
+};
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Evaluates a Board by loading it into a per-thread BBC-style scratch board.
+// Used outside the search, which evaluates its own board directly.
+// -----------------------------------------------------------------------------
+int Engine::evaluate(const Board &board) const {
+  static thread_local BBCStyleEngine scratch;
+  scratch.loadFromBoard(board);
+  return evaluate(scratch);
 }
 
 // -----------------------------------------------------------------------------
 // Evaluates the given board position and returns a score. Positive values favor
-// White, negative values favor Black.
+// the side to move.
 // -----------------------------------------------------------------------------
-int Engine::evaluate(const Board &b) const {
+int Engine::evaluate(const BBCStyleEngine &position) const {
   using namespace EvalParams;
-  GamePhase phase = getGamePhase(b);
+  const BBCBoardView b{position};
+  GamePhase phase = phaseFromOccupancy(position.occupancies[both]);
   int score = 0;
   uint64_t pieces;
   int whiteFileCounts[8] = {0};
@@ -255,22 +279,12 @@ int Engine::evaluate(const Board &b) const {
     developBonus = DEVELOP_BONUS_ENDGAME;
   }
 
-  // Calculate mobility using BBC-style engine
-  BBCStyleEngine tempEngine;
-  std::string fen = b.getFEN();
-  tempEngine.loadFromFEN(fen.c_str());
-  
-  // White mobility
-  tempEngine.side = white;
-  BBCStyleEngine::MoveList whiteMoves;
-  tempEngine.generateMoves(whiteMoves);
-  int whiteMobility = whiteMoves.count;
-  
-  // Black mobility  
-  tempEngine.side = black;
-  BBCStyleEngine::MoveList blackMoves;
-  tempEngine.generateMoves(blackMoves);
-  int blackMobility = blackMoves.count;
+  // Mobility is the number of pseudo-legal moves of each side
+  BBCStyleEngine::MoveList mobilityMoves;
+  position.generateMoves(mobilityMoves, white);
+  int whiteMobility = mobilityMoves.count;
+  position.generateMoves(mobilityMoves, black);
+  int blackMobility = mobilityMoves.count;
   
   score += mobilityWeight * (whiteMobility - blackMobility);
 
@@ -326,16 +340,12 @@ int Engine::evaluate(const Board &b) const {
 
     int shieldCount = popcount64(pawns & shield);
     int score = KING_SHIELD_MULTIPLIER * shieldCount;
-    uint64_t area = kingAttackMask(sq);
-    // Calculate attacked squares using BBC-style engine
-    BBCStyleEngine tempEngine2;
-    std::string fen2 = b.getFEN();
-    tempEngine2.loadFromFEN(fen2.c_str());
-    
+    uint64_t area = Attacks::king(sq);
+    // Count the squares around the king attacked by the opponent
     int attacked = 0;
     for (uint64_t m = area; m; m &= m - 1) {
       int s = popLSBIndex(m);
-      if (tempEngine2.isSquareAttacked(s, !white ? white : black))
+      if (position.isSquareAttacked(s, !white ? white : black))
         ++attacked;
     }
     score -= KING_ATTACK_PENALTY * attacked;
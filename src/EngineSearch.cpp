@@ -1,6 +1,8 @@
 #include "Engine.h"
 #include "BitUtils.h"
+#include "EvalParams.h"
 #include "MVVLVA.h"
+#include "MovePicker.h"
 #include "MoveEncoding.h"
 #include "BBCStyleEngine.h"
 #include <algorithm>
@@ -8,511 +10,701 @@
 #include <atomic>
 #include <future>
 #include <iostream>
-#include <sstream>
 #include <array>
+#include <cmath>
+#include <cstdlib>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 // -----------------------------------------------------------------------------
 // BBC-Style Engine Integration Helpers
 // -----------------------------------------------------------------------------
 
-// Convert Board to BBC-style format
-static void boardToBBC(const Board& board, BBCStyleEngine& bbc) {
-    std::string fen = board.getFEN();
-    bbc.loadFromFEN(fen.c_str());
-}
-
-// Convert BBC move to uint16_t format
-static uint16_t bbcMoveToUint16(const BBCStyleEngine::Move& bbcMove) {
-    // Convert BBC-style move to our internal format
-    int from = bbcMove.source();
-    int to = bbcMove.target();
-    int special = 0;
-    
-    if (bbcMove.castling()) special = 3;
-    else if (bbcMove.promoted()) special = 1;
-    
-    return (to & 0x3f) | ((from & 0x3f) << 6) | ((special & 0x3) << 14);
-}
-
-// Convert uint16_t move to BBC format (for compatibility)
-static BBCStyleEngine::Move uint16ToBBCMove(uint16_t move, const BBCStyleEngine& bbc) {
-    int from = (move >> 6) & 0x3f;
-    int to = move & 0x3f;
-    int special = (move >> 14) & 0x3;
-    
-    // Determine piece type from source square
-    int piece = 0;
-    for (int p = 0; p < 12; p++) {
-        if (get_bit(bbc.bitboards[p], from)) {
-            piece = p;
-            break;
-        }
-    }
-    
-    return BBCStyleEngine::Move(from, to, piece, 0, 0, 0, 0, (special == 3) ? 1 : 0);
-}
-
 // -----------------------------------------------------------------------------
-// Converts an encoded move into the compact UCI format (e.g., e2e4).
+// Converts an encoded move into the compact UCI format (e.g., e2e4, e7e8q).
 // -----------------------------------------------------------------------------
 static std::string toUCIMove(uint16_t move) {
-    std::string uci = decodeMove(move);
-    auto dash = uci.find('-');
-    if (dash != std::string::npos) uci.erase(dash, 1);
+    auto square = [](int idx) {
+        return std::string{static_cast<char>('a' + idx % 8),
+                           static_cast<char>('1' + idx / 8)};
+    };
+    std::string uci = square(moveFrom(move)) + square(moveTo(move));
+    if (moveSpecial(move) == 1)
+        uci += "nbrq"[movePromotion(move)];
     return uci;
 }
 
 // -----------------------------------------------------------------------------
-// Determines if the provided move results in a capture on the target square or
-// via en passant.
+// Computes a heuristic score for move ordering using MVV/LVA. BBC piece codes
+// modulo 6 are the MVVLVA piece types.
 // -----------------------------------------------------------------------------
-static bool isCaptureMove(const Board& board, uint16_t move) {
-    int from = moveFrom(move);
-    int to = moveTo(move);
-    Board::Color colorAtTo = board.pieceColorAt(to);
-    if (board.isWhiteToMove()) {
-        if (colorAtTo == Board::Color::Black) return true;
-    } else {
-        if (colorAtTo == Board::Color::White) return true;
-    }
-    if (board.getEnPassantSquare() == to) {
-        uint64_t fromMask = 1ULL << from;
-        if (board.isWhiteToMove()) {
-            if (board.getWhitePawns() & fromMask) return true;
-        } else {
-            if (board.getBlackPawns() & fromMask) return true;
+static int moveScore(const BBCStyleEngine& pos,
+                     const BBCStyleEngine::Move& move) {
+    if (!move.capture()) return 0;
+    int attackerType = move.piece() % 6;
+    int victimType = MVVLVA::Pawn;  // en passant
+    if (!move.enpass()) {
+        int first = pos.side == white ? p : P;
+        for (int piece = first; piece < first + 6; ++piece) {
+            if (get_bit(pos.bitboards[piece], move.target())) {
+                victimType = piece % 6;
+                break;
+            }
         }
     }
-    return false;
+    return MVVLVA::Table[victimType][attackerType] * 10;  // Scale up for better move ordering
 }
 
 // -----------------------------------------------------------------------------
-// Returns the material value of the piece located at the given board index.
+// Returns true if the position at the given ply already occurred on the search
+// path or in the game since the last irreversible move. Only every second
+// entry can have the same side to move.
 // -----------------------------------------------------------------------------
-static int pieceValueAt(const Board& board, int index) {
-    uint64_t mask = 1ULL << index;
-    if (board.getWhitePawns() & mask || board.getBlackPawns() & mask) return 100;
-    if (board.getWhiteKnights() & mask || board.getBlackKnights() & mask) return 320;
-    if (board.getWhiteBishops() & mask || board.getBlackBishops() & mask) return 330;
-    if (board.getWhiteRooks() & mask || board.getBlackRooks() & mask) return 500;
-    if (board.getWhiteQueens() & mask || board.getBlackQueens() & mask) return 900;
-    if (board.getWhiteKing() & mask || board.getBlackKing() & mask) return 20000;
-    return 0;
+static bool isRepetition(const SearchContext& ctx, int ply, int fifty) {
+    int index = ctx.rootIndex + ply;
+    uint64_t key = ctx.keyStack[index];
+    for (int i = index - 2; i >= 0 && i >= index - fifty; i -= 2)
+        if (ctx.keyStack[i] == key) return true;
+    return false;
 }
 
 // -----------------------------------------------------------------------------
-// Returns the MVVLVA piece type at a given board index used for move ordering.
+// Mate scores are relative to the root inside the search and relative to the
+// node in the transposition table, so that a stored mate stays correct when
+// the position is reached at another ply.
 // -----------------------------------------------------------------------------
-static int pieceTypeAt(const Board& board, int index) {
-    uint64_t mask = 1ULL << index;
-    if (board.getWhitePawns() & mask || board.getBlackPawns() & mask) return MVVLVA::Pawn;
-    if (board.getWhiteKnights() & mask || board.getBlackKnights() & mask) return MVVLVA::Knight;
-    if (board.getWhiteBishops() & mask || board.getBlackBishops() & mask) return MVVLVA::Bishop;
-    if (board.getWhiteRooks() & mask || board.getBlackRooks() & mask) return MVVLVA::Rook;
-    if (board.getWhiteQueens() & mask || board.getBlackQueens() & mask) return MVVLVA::Queen;
-    if (board.getWhiteKing() & mask || board.getBlackKing() & mask) return MVVLVA::King;
-    return MVVLVA::Pawn; // default, should not happen for valid board
+static int valueToTT(int score, int ply) {
+    if (score >= Engine::MATE_BOUND) return score + ply;
+    if (score <= -Engine::MATE_BOUND) return score - ply;
+    return score;
 }
 
-// -----------------------------------------------------------------------------
-// Recursively evaluates a capture sequence starting on the given square using
-// static exchange evaluation (SEE).
-// -----------------------------------------------------------------------------
-static int seeRec(const MoveGenerator& gen, Board& board, int square) {
-    bool side = board.isWhiteToMove();
-    auto pseudo = gen.generateAllMoves(board, side);
-    int best = -1000000;
-    bool any = false;
-    for (auto mv : pseudo) {
-        int to = moveTo(mv);
-        if (to != square) continue;
-        if (!board.isMoveLegal(mv)) continue;
-        any = true;
-        int from = moveFrom(mv);
-        int val = pieceValueAt(board, from);
-        Board::MoveState state;
-        board.makeMove(mv, state);
-        int gain = val - seeRec(gen, board, square);
-        board.unmakeMove(state);
-        if (gain > best) best = gain;
-    }
-    if (!any) return 0;
-    return best;
+static int valueFromTT(int score, int ply) {
+    if (score >= Engine::MATE_BOUND) return score - ply;
+    if (score <= -Engine::MATE_BOUND) return score + ply;
+    return score;
 }
 
 // -----------------------------------------------------------------------------
-// Performs static exchange evaluation for a given move by simulating the capture
-// sequence on the target square.
-// -----------------------------------------------------------------------------
-static int staticExchangeEval(const MoveGenerator& gen,
-                              Board& board,
-                              uint16_t move) {
-    int from = moveFrom(move);
-    int to = moveTo(move);
-    if (!isCaptureMove(board, move)) return 0;
-    int captured = pieceValueAt(board, to);
-    if (!captured && board.getEnPassantSquare() == to)
-        captured = 100;
-    Board::MoveState state;
-    board.makeMove(move, state);
-    int result = captured - seeRec(gen, board, to);
-    board.unmakeMove(state);
-    return result;
-}
-
+// Material won by a capture or promotion, for delta pruning.
 // -----------------------------------------------------------------------------
-// Computes a heuristic score for move ordering using MVV/LVA and SEE.
-// -----------------------------------------------------------------------------
-static int moveScore(Board& board,
-                     uint16_t move,
-                     BBCStyleEngine& bbcEngine) {
-    int from = moveFrom(move);
-    int to = moveTo(move);
-    int capturedVal = pieceValueAt(board, to);
-    if (!capturedVal && board.getEnPassantSquare() == to)
-        capturedVal = 100;
-    if (capturedVal) {
-        int attackerType = pieceTypeAt(board, from);
-        int victimType = pieceTypeAt(board, to);
-        if (board.getEnPassantSquare() == to)
-            victimType = MVVLVA::Pawn;
-        int score = MVVLVA::Table[victimType][attackerType];
-        // Simplified SEE for BBC-style - just return basic MVV/LVA score
-        return score * 10;  // Scale up for better move ordering
+static int captureGain(const BBCStyleEngine& pos, const BBCStyleEngine::Move& move) {
+    static constexpr int VALUES[6] = {
+        EvalParams::PAWN_VALUE, EvalParams::KNIGHT_VALUE, EvalParams::BISHOP_VALUE,
+        EvalParams::ROOK_VALUE, EvalParams::QUEEN_VALUE, 0};
+    int gain = 0;
+    if (move.enpass()) {
+        gain = EvalParams::PAWN_VALUE;
+    } else if (move.capture()) {
+        int first = pos.side == white ? p : P;
+        for (int piece = first; piece < first + 6; ++piece) {
+            if (get_bit(pos.bitboards[piece], move.target())) {
+                gain = VALUES[piece % 6];
+                break;
+            }
+        }
     }
-    return 0;
+    if (move.promoted())
+        gain += VALUES[move.promoted() % 6] - EvalParams::PAWN_VALUE;
+    return gain;
 }
 
-// -----------------------------------------------------------------------------
-// Engine constructor ensures Zobrist keys are initialized once.
-// -----------------------------------------------------------------------------
-Engine::Engine() {
-    static bool init = false;
-    if (!init) { Zobrist::init(); init = true; }
+namespace {
+// Delta pruning: a capture is skipped when winning the captured piece plus
+// this margin still leaves the stand-pat score at or below alpha
+constexpr int DELTA_MARGIN = 200;
 }
 
 // -----------------------------------------------------------------------------
-// Quiescence search that explores only capture moves to stabilize evaluation.
+// Quiescence search. Resolves captures until the position is quiet, so that
+// the static evaluation is not taken in the middle of an exchange. Captures
+// come from the move picker best MVV-LVA first, without those losing material
+// by static exchange, and those that cannot raise alpha even with a margin are
+// pruned. A side in check has no stand-pat option and searches every evasion.
+// Results are shared with the main search through the transposition table as
+// depth 0 entries. Scores are relative to the side to move.
 // -----------------------------------------------------------------------------
-int Engine::quiescence(Board& board, int alpha, int beta, bool maximizing,
+int Engine::quiescence(SearchContext& ctx, int alpha, int beta,
                        const std::chrono::steady_clock::time_point& end,
-                       const std::atomic<bool>& stop) {
-    if (stop || std::chrono::steady_clock::now() >= end)
-        return (board.isWhiteToMove() ? 1 : -1) * evaluate(board);
-    nodes++;
-    int standPat = (board.isWhiteToMove() ? 1 : -1) * evaluate(board);
-    if (maximizing) {
+                       const std::atomic<bool>& stop, int ply) {
+    BBCStyleEngine& pos = ctx.bbc;
+    if (stop || std::chrono::steady_clock::now() >= end ||
+        ply >= SearchContext::MAX_PLY - 1)
+        return evaluate(pos);
+    ctx.countNode();
+
+    uint64_t key = pos.hashKey;
+    TTEntry entry{};
+    uint16_t ttMove = 0;
+    if (tt.probe(key, entry)) {
+        ttMove = entry.move;
+        int value = valueFromTT(entry.value, ply);
+        if (entry.flag == 0 || (entry.flag == 1 && value >= beta) ||
+            (entry.flag == -1 && value <= alpha))
+            return value;
+    }
+
+    bool inCheck = pos.inCheck();
+    int alphaOrig = alpha;
+    int standPat = 0;
+    int bestScore = -MATE + ply;
+    if (!inCheck) {
+        standPat = evaluate(pos);
         if (standPat >= beta) return standPat;
         if (standPat > alpha) alpha = standPat;
-    } else {
-        if (standPat <= alpha) return standPat;
-        if (standPat < beta) beta = standPat;
+        bestScore = standPat;
     }
 
-    // Generate moves using BBC-style engine
-    boardToBBC(board, bbcEngine);
-    BBCStyleEngine::MoveList bbcMoves;
-    bbcEngine.generateMoves(bbcMoves);
-    
-    std::vector<uint16_t> moves;
-    for (int i = 0; i < bbcMoves.count; i++) {
-        uint16_t move = bbcMoveToUint16(bbcMoves.moves[i]);
-        if (board.isMoveLegal(move) && isCaptureMove(board, move)) {
-            moves.push_back(move);
+    int sideIndex = pos.side == white ? 0 : 1;
+    MovePicker picker = inCheck
+        ? MovePicker(pos, ctx.moveLists[ply], ttMove, ctx.killerMoves[ply],
+                     ctx.historyTable[sideIndex])
+        : MovePicker(pos, ctx.moveLists[ply], ttMove);
+    BBCStyleEngine::Move m;
+    int legal = 0;
+    uint16_t bestMove = 0;
+    while (picker.next(m)) {
+        if (!inCheck) {
+            int optimistic = standPat + captureGain(pos, m) + DELTA_MARGIN;
+            if (optimistic <= alpha) {
+                bestScore = std::max(bestScore, optimistic);
+                continue;
+            }
         }
-    }
-
-    for (auto m : moves) {
-        Board::MoveState state;
-        board.makeMove(m, state);
-        int score = quiescence(board, alpha, beta, !maximizing, end, stop);
-        board.unmakeMove(state);
-        if (maximizing) {
-            if (score > alpha) alpha = score;
-        } else {
-            if (score < beta) beta = score;
+        pos.copyBoard();
+        if (!pos.makeMove(m)) {
+            pos.takeBack();
+            continue;
+        }
+        ++legal;
+        if (ttPrefetch) tt.prefetch(pos.hashKey);
+        int score = -quiescence(ctx, -beta, -alpha, end, stop, ply + 1);
+        pos.takeBack();
+        if (stop || std::chrono::steady_clock::now() >= end)
+            return 0;
+        if (score <= bestScore) continue;
+        bestScore = score;
+        if (score > alpha) {
+            bestMove = bbcMoveToUint16(m);
+            alpha = score;
+            if (alpha >= beta) break;
         }
-        if (beta <= alpha) break;
     }
-    return maximizing ? alpha : beta;
+    if (inCheck && !legal)
+        return -MATE + ply;
+
+    TTEntry save{0, valueToTT(bestScore, ply), 0, bestMove};
+    if (bestScore <= alphaOrig) save.flag = -1;
+    else if (bestScore >= beta) save.flag = 1;
+    tt.store(key, save);
+    return bestScore;
 }
 
-// -----------------------------------------------------------------------------
-// Negamax search with alpha-beta pruning. Returns the evaluated score from the
-// perspective of the current player.
-// -----------------------------------------------------------------------------
-int Engine::negamaxAlphaBeta(Board& board, int depth,
-                             int alpha, int beta, int color,
-                             const std::chrono::steady_clock::time_point& end,
-                             const std::atomic<bool>& stop) {
-    if (stop || std::chrono::steady_clock::now() >= end)
-        return color * evaluate(board);
-    if (board.isFiftyMoveDraw() || board.isThreefoldRepetition())
-        return 0;
-    if (depth == 0)
-        return color * evaluate(board);
-
-    // Generate moves using BBC-style engine
-    boardToBBC(board, bbcEngine);
-    BBCStyleEngine::MoveList bbcMoves;
-    bbcEngine.generateMoves(bbcMoves);
-    
-    std::vector<uint16_t> moves;
-    for (int i = 0; i < bbcMoves.count; i++) {
-        uint16_t move = bbcMoveToUint16(bbcMoves.moves[i]);
-        if (board.isMoveLegal(move))
-            moves.push_back(move);
-    }
+namespace {
+// Late move reductions: quiet moves from the LMR_MIN_MOVES-th legal move on
+// are searched LMR_REDUCTIONS[depth][moveIndex] plies shallower first. The
+// reduction grows with the logarithm of both, as in most engines since
+// Stockfish 2.
+constexpr int LMR_MIN_DEPTH = 3;
+constexpr int LMR_MIN_MOVES = 3;
+constexpr int LMR_MAX_DEPTH = 64;
+constexpr int LMR_MAX_MOVES = 64;
+// History score at which a quiet move is reduced one ply less
+constexpr int LMR_HISTORY_STEP = 1024;
 
-    if (moves.empty()) {
-        boardToBBC(board, bbcEngine);
-        int kingSq = board.isWhiteToMove() ? __builtin_ctzll(board.getWhiteKing()) : __builtin_ctzll(board.getBlackKing());
-        bool inCheck = bbcEngine.isSquareAttacked(kingSq, board.isWhiteToMove() ? black : white);
-        if (inCheck)
-            return -1000000 * color;
-        return 0;
-    }
+const auto LMR_REDUCTIONS = [] {
+    std::array<std::array<int, LMR_MAX_MOVES>, LMR_MAX_DEPTH> table{};
+    for (int depth = 1; depth < LMR_MAX_DEPTH; ++depth)
+        for (int index = 1; index < LMR_MAX_MOVES; ++index)
+            table[depth][index] = static_cast<int>(
+                0.75 + std::log(depth) * std::log(index) / 2.25);
+    return table;
+}();
 
-    for (auto m : moves) {
-        std::string sm = decodeMove(m);
-        Board::MoveState st;
-        board.makeMove(sm, st);
-        int score = -negamaxAlphaBeta(board, depth - 1,
-                                      -beta, -alpha, -color, end, stop);
-        board.unmakeMove(st);
-        if (score >= beta)
-            return score;
-        if (score > alpha)
-            alpha = score;
-    }
-    return alpha;
+int lateMoveReduction(int depth, int moveIndex) {
+    return LMR_REDUCTIONS[std::min(depth, LMR_MAX_DEPTH - 1)]
+                         [std::min(moveIndex, LMR_MAX_MOVES - 1)];
 }
 
+// Forward pruning margins in centipawns, applied in non-PV nodes only.
+// Reverse futility returns the static evaluation when it beats beta by
+// RFP_MARGIN per ply of remaining depth; razoring drops into quiescence when
+// it is RAZOR_MARGIN per ply below alpha; futility pruning skips quiet moves
+// when even FUTILITY_MARGIN per ply cannot lift it to alpha; late move
+// pruning skips the quiet moves after the first LMP_BASE + depth^2 moves.
+constexpr int RFP_MAX_DEPTH = 6;
+constexpr int RFP_MARGIN = 100;
+constexpr int RAZOR_MAX_DEPTH = 3;
+constexpr int RAZOR_MARGIN = 300;
+constexpr int FUTILITY_MAX_DEPTH = 3;
+constexpr int FUTILITY_MARGIN = 150;
+constexpr int LMP_MAX_DEPTH = 6;
+constexpr int LMP_BASE = 3;
+
+// Null move reduction: NULL_REDUCTION plies plus one for every
+// NULL_DEPTH_DIVISOR plies of depth and one for every NULL_EVAL_DIVISOR
+// centipawns the static evaluation is above beta, up to three.
+constexpr int NULL_MIN_DEPTH = 3;
+constexpr int NULL_REDUCTION = 1;
+constexpr int NULL_DEPTH_DIVISOR = 3;
+constexpr int NULL_EVAL_DIVISOR = 200;
+constexpr int NULL_VERIFY_DEPTH = 10;
+} // namespace
+
 // -----------------------------------------------------------------------------
-// Full-featured minimax search with alpha-beta pruning, null-move pruning and
-// killer move heuristics. Returns the evaluation score and principal variation.
+// Principal variation search with alpha-beta pruning, null-move pruning, late
+// move reductions, static-evaluation forward pruning and killer move
+// heuristics on the context's BBC-style board using copy-make.
+// Returns the score for the side to move and leaves the principal variation
+// of the node in ctx.pv[ply].
 // -----------------------------------------------------------------------------
-std::pair<int, std::string> Engine::minimax(
-        Board& board, int depth, int alpha, int beta, bool maximizing,
-        const std::chrono::steady_clock::time_point& end,
-        const std::atomic<bool>& stop, int ply) {
-    constexpr int MAX_PLY = 64;
-    static thread_local std::array<std::array<uint16_t, 2>, MAX_PLY> killerMoves{};
-    static thread_local int historyTable[2][64][64];
-    if (ply == 0) {
-        for (auto& km : killerMoves) { km[0] = km[1] = 0; }
-        for (int s = 0; s < 2; ++s)
-            for (int f = 0; f < 64; ++f)
-                for (int t = 0; t < 64; ++t)
-                    historyTable[s][f][t] = 0;
-    }
-    if (stop || std::chrono::steady_clock::now() >= end)
-        return {(board.isWhiteToMove() ? 1 : -1) * evaluate(board), ""};
-    if (board.isFiftyMoveDraw() || board.isThreefoldRepetition())
-        return {0, ""};
-    uint64_t key = Zobrist::hashBoard(board);
+int Engine::negamax(SearchContext& ctx, int depth, int alpha, int beta,
+                    const std::chrono::steady_clock::time_point& end,
+                    const std::atomic<bool>& stop, int ply) {
+    constexpr int MAX_PLY = SearchContext::MAX_PLY;
+    BBCStyleEngine& pos = ctx.bbc;
+    auto& killerMoves = ctx.killerMoves;
+    auto& historyTable = ctx.historyTable;
+    ctx.pvLength[ply] = ply;
+    if (stop || std::chrono::steady_clock::now() >= end || ply >= MAX_PLY - 1)
+        return evaluate(pos);
+    uint64_t key = pos.hashKey;
+    ctx.keyStack[ctx.rootIndex + ply] = key;
+    if (pos.fifty >= 100 || isRepetition(ctx, ply, pos.fifty))
+        return 0;
+    if (depth <= 0)
+        return quiescence(ctx, alpha, beta, end, stop, ply);
+    bool pvNode = beta - alpha > 1;
     TTEntry entry{};
     uint16_t ttMove = 0;
     bool hit = tt.probe(key, entry);
     if (hit) ttMove = entry.move;
-    if (hit && entry.depth >= depth) {
-        if (entry.flag == 0)
-            return {entry.value, decodeMove(ttMove)};
-        if (entry.flag == 1 && entry.value >= beta)
-            return {entry.value, decodeMove(ttMove)};
-        if (entry.flag == -1 && entry.value <= alpha)
-            return {entry.value, decodeMove(ttMove)};
+    // PV nodes are always searched, so that the principal variation is the
+    // complete line rather than ending at the first table hit
+    if (hit && !pvNode && entry.depth >= depth) {
+        int value = valueFromTT(entry.value, ply);
+        if (entry.flag == 0 || (entry.flag == 1 && value >= beta) ||
+            (entry.flag == -1 && value <= alpha))
+            return value;
     }
-    nodes++;
+    ctx.countNode();
     int alphaOrig = alpha;
-    if (depth == 0)
-        return {quiescence(board, alpha, beta, maximizing, end, stop), ""};
-
-    const int NULL_REDUCTION = 2;
-    uint64_t otherPieces =
-            ((board.getWhitePieces() | board.getBlackPieces()) &
-             ~(board.getWhiteKing() | board.getBlackKing()));
-    if (depth >= 3 && otherPieces) {
-        // Simplified null move check - BBC-style engines handle this internally
-        boardToBBC(board, bbcEngine);
-        int kingSq = board.isWhiteToMove() ? __builtin_ctzll(board.getWhiteKing()) : __builtin_ctzll(board.getBlackKing());
-        bool inCheck = bbcEngine.isSquareAttacked(kingSq, board.isWhiteToMove() ? black : white);
-        
-        if (!inCheck) {
-        Board nullBoard = board;
-        nullBoard.setWhiteToMove(!board.isWhiteToMove());
-        nullBoard.setEnPassantSquare(-1);
-        int rDepth = depth - 1 - NULL_REDUCTION;
-        if (rDepth < 0) rDepth = 0;
-        std::pair<int, std::string> nullRes;
-        if (maximizing) {
-            nullRes = minimax(nullBoard, rDepth, beta - 1, beta,
-                              false, end, stop, ply + 1);
-            if (nullRes.first >= beta)
-                return {nullRes.first, ""};
+
+    bool inCheck = pos.inCheck();
+    // The static evaluation only guides pruning, which is never done in PV
+    // nodes, in check or against mate bounds
+    bool canPrune = !pvNode && !inCheck;
+    int staticEval = canPrune ? evaluate(pos) : 0;
+
+    // Reverse futility: far enough above beta that no quiet continuation is
+    // expected to bring the score back down
+    if (pruning.reverseFutility && canPrune && depth <= RFP_MAX_DEPTH &&
+        std::abs(beta) < MATE_BOUND && staticEval - RFP_MARGIN * depth >= beta)
+        return staticEval;
+
+    // Razoring: far enough below alpha that only captures can help, so a
+    // quiescence search decides whether the node is worth searching
+    if (pruning.razoring && canPrune && depth <= RAZOR_MAX_DEPTH &&
+        std::abs(alpha) < MATE_BOUND && staticEval + RAZOR_MARGIN * depth <= alpha) {
+        int score = quiescence(ctx, alpha, alpha + 1, end, stop, ply);
+        if (score <= alpha)
+            return score;
+    }
+
+    // Null move: if passing the turn still fails high on a reduced search,
+    // the node very likely fails high. Only tried when the side to move has a
+    // piece besides pawns and king, as zugzwang is rare then.
+    int us = pos.side == white ? 0 : 6;
+    uint64_t pieces = pos.bitboards[N + us] | pos.bitboards[B + us] |
+                      pos.bitboards[R + us] | pos.bitboards[Q + us];
+    if (canPrune && depth >= NULL_MIN_DEPTH && pieces && staticEval >= beta &&
+        std::abs(beta) < MATE_BOUND && ply >= ctx.nullMoveMinPly) {
+        int reduction = NULL_REDUCTION + depth / NULL_DEPTH_DIVISOR +
+                        std::min((staticEval - beta) / NULL_EVAL_DIVISOR, 3);
+        int nullDepth = std::max(0, depth - 1 - reduction);
+        BBCStyleEngine::NullMoveState state = pos.makeNullMove();
+        if (ttPrefetch) tt.prefetch(pos.hashKey);
+        int score = -negamax(ctx, nullDepth, -beta, -beta + 1, end, stop, ply + 1);
+        pos.unmakeNullMove(state);
+        if (score >= beta) {
+            // A mate found after passing is not a proven mate
+            if (score >= MATE_BOUND) score = beta;
+            if (depth < NULL_VERIFY_DEPTH || ctx.nullMoveMinPly)
+                return score;
+            // Deep cutoffs are confirmed by a reduced search of the node
+            // itself with null move disabled for the first plies, so that a
+            // zugzwang cannot prune a whole subtree
+            ctx.nullMoveMinPly = ply + 3 * nullDepth / 4 + 1;
+            int verified = negamax(ctx, nullDepth, beta - 1, beta, end, stop, ply);
+            ctx.nullMoveMinPly = 0;
+            if (verified >= beta)
+                return score;
+        }
+    }
+
+    int sideIndex = pos.side == white ? 0 : 1;
+    MovePicker picker(pos, ctx.moveLists[ply], ttMove, killerMoves[ply],
+                      historyTable[sideIndex]);
+    BBCStyleEngine::Move m;
+    int legal = 0;
+    int bestScore = -MATE;
+    uint16_t bestMove = 0;
+    while (picker.next(m)) {
+        pos.copyBoard();
+        if (!pos.makeMove(m)) {
+            pos.takeBack();
+            continue;
+        }
+        bool first = legal++ == 0;
+        bool quiet = !m.capture() && !m.promoted();
+        bool givesCheck = pos.inCheck();
+
+        // Quiet moves that cannot raise alpha this close to the horizon.
+        // Once a move has escaped a mate there is always one to fall back on.
+        if (canPrune && !first && quiet && !givesCheck &&
+            bestScore > -MATE_BOUND && std::abs(alpha) < MATE_BOUND) {
+            if ((pruning.futility && depth <= FUTILITY_MAX_DEPTH &&
+                 staticEval + FUTILITY_MARGIN * depth <= alpha) ||
+                (pruning.lateMovePruning && depth <= LMP_MAX_DEPTH &&
+                 legal > LMP_BASE + depth * depth)) {
+                pos.takeBack();
+                continue;
+            }
+        }
+
+        if (ttPrefetch) tt.prefetch(pos.hashKey);
+        int score;
+        if (first) {
+            score = -negamax(ctx, depth - 1, -beta, -alpha, end, stop, ply + 1);
         } else {
-            nullRes = minimax(nullBoard, rDepth, alpha, alpha + 1,
-                              true, end, stop, ply + 1);
-            if (nullRes.first <= alpha)
-                return {nullRes.first, ""};
+            // Late quiet moves are first searched at reduced depth; less so
+            // in PV nodes, for killers, checks and moves with good history
+            int reduction = 0;
+            if (depth >= LMR_MIN_DEPTH && legal >= LMR_MIN_MOVES && !inCheck && quiet) {
+                uint16_t compact = bbcMoveToUint16(m);
+                reduction = lateMoveReduction(depth, legal);
+                if (pvNode) --reduction;
+                if (compact == killerMoves[ply][0] || compact == killerMoves[ply][1])
+                    --reduction;
+                if (givesCheck) --reduction;
+                reduction -= std::min(
+                    historyTable[sideIndex][m.source()][m.target()] / LMR_HISTORY_STEP, 2);
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
+            score = -negamax(ctx, depth - 1 - reduction, -alpha - 1, -alpha, end,
+                             stop, ply + 1);
+            if (reduction > 0 && score > alpha)
+                score = -negamax(ctx, depth - 1, -alpha - 1, -alpha, end, stop, ply + 1);
+            if (score > alpha && score < beta)
+                score = -negamax(ctx, depth - 1, -beta, -alpha, end, stop, ply + 1);
+        }
+        pos.takeBack();
+        // An interrupted child returns a static evaluation; nothing of this
+        // node may reach the heuristics, the PV or the table
+        if (stop || std::chrono::steady_clock::now() >= end)
+            return 0;
+        if (score <= bestScore) continue;
+        bestScore = score;
+        uint16_t compact = bbcMoveToUint16(m);
+        if (score > alpha) {
+            // Only a move that raised alpha is worth storing: after a fail
+            // low the table keeps the move of an earlier, wider search
+            bestMove = compact;
+            alpha = score;
+            ctx.updatePV(ply, compact);
+            if (!m.capture())
+                historyTable[sideIndex][m.source()][m.target()] += depth * depth;
         }
+        if (alpha >= beta) {
+            if (!m.capture() && killerMoves[ply][0] != compact) {
+                killerMoves[ply][1] = killerMoves[ply][0];
+                killerMoves[ply][0] = compact;
+            }
+            break;
         }
     }
-    
-    // Generate moves using BBC-style engine
-    boardToBBC(board, bbcEngine);
-    BBCStyleEngine::MoveList bbcMoves;
-    bbcEngine.generateMoves(bbcMoves);
-    
-    std::vector<uint16_t> moves;
-    for (int i = 0; i < bbcMoves.count; i++) {
-        uint16_t move = bbcMoveToUint16(bbcMoves.moves[i]);
-        if (board.isMoveLegal(move))
-            moves.push_back(move);
+    if (!legal)
+        return inCheck ? -MATE + ply : 0;
+    TTEntry save{depth, valueToTT(bestScore, ply), 0, bestMove};
+    if (bestScore <= alphaOrig) save.flag = -1;
+    else if (bestScore >= beta) save.flag = 1;
+    tt.store(key, save);
+    return bestScore;
+}
+
+// -----------------------------------------------------------------------------
+// Generates the legal root moves of the context's board ordered by the capture
+// heuristics.
+// -----------------------------------------------------------------------------
+std::vector<BBCStyleEngine::Move> Engine::generateRootMoves(SearchContext& ctx) {
+    BBCStyleEngine& pos = ctx.bbc;
+    BBCStyleEngine::MoveList& list = ctx.moveLists[0];
+    pos.generateMoves(list);
+
+    std::vector<BBCStyleEngine::Move> moves;
+    for (int i = 0; i < list.count; i++) {
+        pos.copyBoard();
+        if (pos.makeMove(list.moves[i]))
+            moves.push_back(list.moves[i]);
+        pos.takeBack();
     }
-    int sideIndex = board.isWhiteToMove() ? 0 : 1;
-    std::sort(moves.begin(), moves.end(), [&](uint16_t a, uint16_t b) {
-        int scoreA = (a == ttMove) ? 1000000 : moveScore(board, a, bbcEngine);
-        int scoreB = (b == ttMove) ? 1000000 : moveScore(board, b, bbcEngine);
-        if (scoreA == 0 && a != ttMove) {
-            if (killerMoves[ply][0] == a) scoreA = 900;
-            else if (killerMoves[ply][1] == a) scoreA = 800;
-            else {
-                int fa = moveFrom(a);
-                int ta = moveTo(a);
-                scoreA = historyTable[sideIndex][fa][ta];
-            }
+    std::stable_sort(moves.begin(), moves.end(),
+                     [&](const BBCStyleEngine::Move& a, const BBCStyleEngine::Move& b) {
+                         return moveScore(pos, a) > moveScore(pos, b);
+                     });
+    return moves;
+}
+
+// -----------------------------------------------------------------------------
+// Searches every root move to the given depth with a principal variation
+// search inside the window (alpha, beta). Alpha is carried from one root move
+// to the next, so later moves are searched with a null window around the
+// current best. A score at or above beta ends the iteration early; a result
+// at or below the original alpha only bounds the true score from above.
+// -----------------------------------------------------------------------------
+Engine::RootResult Engine::searchRoot(
+        SearchContext& ctx, const std::vector<BBCStyleEngine::Move>& moves,
+        int depth, int alpha, int beta,
+        const std::chrono::steady_clock::time_point& end,
+        const std::atomic<bool>& stop) {
+    BBCStyleEngine& pos = ctx.bbc;
+    RootResult result;
+    bool first = true;
+    for (const auto& m : moves) {
+        pos.copyBoard();
+        pos.makeMove(m);
+        if (ttPrefetch) tt.prefetch(pos.hashKey);
+        int score;
+        if (first) {
+            score = -negamax(ctx, depth - 1, -beta, -alpha, end, stop, 1);
+        } else {
+            score = -negamax(ctx, depth - 1, -alpha - 1, -alpha, end, stop, 1);
+            if (score > alpha && score < beta)
+                score = -negamax(ctx, depth - 1, -beta, -alpha, end, stop, 1);
         }
-        if (scoreB == 0 && b != ttMove) {
-            if (killerMoves[ply][0] == b) scoreB = 900;
-            else if (killerMoves[ply][1] == b) scoreB = 800;
-            else {
-                int fb = moveFrom(b);
-                int tb = moveTo(b);
-                scoreB = historyTable[sideIndex][fb][tb];
-            }
+        pos.takeBack();
+        // A search interrupted by the clock returns a static evaluation, so
+        // its score must not replace the best move found so far.
+        if (stop || std::chrono::steady_clock::now() >= end)
+            return result;
+
+        if (first || score > alpha) {
+            result.score = score;
+            result.move = m;
+            ctx.updatePV(0, bbcMoveToUint16(m));
+            result.pvLength = ctx.pvLength[0];
+            std::copy(ctx.pv[0], ctx.pv[0] + result.pvLength, result.pv.begin());
         }
-        return scoreA > scoreB;
-    });
-    if (moves.empty()) {
-        boardToBBC(board, bbcEngine);
-        int kingSq = board.isWhiteToMove() ? __builtin_ctzll(board.getWhiteKing()) : __builtin_ctzll(board.getBlackKing());
-        bool inCheck = bbcEngine.isSquareAttacked(kingSq, board.isWhiteToMove() ? black : white);
-        if (inCheck) {
-            int mateScore = board.isWhiteToMove() ? -1000000 : 1000000;
-            return {mateScore, ""};
+        if (score > alpha) alpha = score;
+        first = false;
+        if (alpha >= beta) break;
+    }
+    result.complete = true;
+    return result;
+}
+
+namespace {
+// Aspiration windows: iterations from this depth on start with a window of
+// ASPIRATION_DELTA centipawns on each side of the previous score. Scores move
+// by a pawn or more between shallow depths, and a failed window costs almost
+// a full iteration, so the window is kept wide.
+constexpr int ASPIRATION_MIN_DEPTH = 4;
+constexpr int ASPIRATION_DELTA = 75;
+}
+
+// -----------------------------------------------------------------------------
+// Runs one root iteration inside an aspiration window around the score of the
+// previous iteration. When the result falls outside the window, the failing
+// side is moved out by a margin that doubles with every re-search until the
+// score is exact; after a fail low the upper bound is also pulled towards the
+// failed lower bound. Mate scores always get the full window.
+// -----------------------------------------------------------------------------
+Engine::RootResult Engine::aspirationSearch(
+        SearchContext& ctx, const std::vector<BBCStyleEngine::Move>& moves,
+        int depth, int previousScore,
+        const std::chrono::steady_clock::time_point& end,
+        const std::atomic<bool>& stop) {
+    int delta = ASPIRATION_DELTA;
+    int alpha = -MATE;
+    int beta = MATE;
+    if (depth >= ASPIRATION_MIN_DEPTH && std::abs(previousScore) < MATE_BOUND) {
+        alpha = std::max(previousScore - delta, -MATE);
+        beta = std::min(previousScore + delta, MATE);
+    }
+    while (true) {
+        RootResult res = searchRoot(ctx, moves, depth, alpha, beta, end, stop);
+        if (!res.complete)
+            return res;
+        if (res.score <= alpha && alpha > -MATE) {
+            ctx.countResearch(false);
+            beta = (alpha + beta) / 2;
+            alpha = std::max(res.score - delta, -MATE);
+        } else if (res.score >= beta && beta < MATE) {
+            ctx.countResearch(true);
+            beta = std::min(res.score + delta, MATE);
+        } else {
+            return res;
         }
-        return {0, ""};
+        delta *= 2;
     }
-    if (maximizing) {
-        int bestEval = -1000000;
-        uint16_t bestMove = 0;
-        std::string bestPV;
-        bool first = true;
-        for (auto m : moves) {
-            bool capture = isCaptureMove(board, m);
-            int from = moveFrom(m);
-            int to = moveTo(m);
-            int plySide = board.isWhiteToMove() ? 0 : 1;
-            Board::MoveState state;
-            board.makeMove(m, state);
-            std::pair<int, std::string> child;
-            if (first) {
-                child = minimax(board, depth - 1, alpha, beta, false, end, stop, ply + 1);
-            } else {
-                child = minimax(board, depth - 1, alpha, alpha + 1,
-                                false, end, stop, ply + 1);
-                int eval = child.first;
-                if (eval > alpha && eval < beta) {
-                    child = minimax(board, depth - 1, eval, beta,
-                                    false, end, stop, ply + 1);
-                }
-            }
-            int eval = child.first;
-            if (eval > bestEval) {
-                bestEval = eval;
-                bestMove = m;
-                bestPV = decodeMove(m);
-                if (!child.second.empty()) bestPV += " " + child.second;
-            }
-            if (eval > alpha) {
-                alpha = eval;
-                if (!capture)
-                    historyTable[plySide][from][to] += depth * depth;
-            }
-            if (alpha >= beta) {
-                if (!capture && ply < MAX_PLY) {
-                    if (killerMoves[ply][0] != m) {
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = m;
-                    }
-                }
-                board.unmakeMove(state);
-                break;
+}
+
+// Depth skew for Lazy SMP helpers: helper i skips an iteration whenever
+// ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) is odd, so that the helpers spread
+// over neighbouring depths instead of duplicating the main thread.
+namespace {
+constexpr int MAX_SEARCH_DEPTH = 64;
+constexpr int SKIP_SIZE[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                               3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+}
+
+// -----------------------------------------------------------------------------
+// Lazy SMP driver. Every helper thread runs its own iterative deepening loop on
+// a private copy of the board and only communicates through the shared
+// transposition table. The calling thread is the main thread: it reports
+// progress and its last completed iteration decides the move.
+// -----------------------------------------------------------------------------
+uint16_t Engine::lazySmpSearch(Board& board, int maxDepth,
+                               const std::chrono::steady_clock::time_point& end,
+                               const std::atomic<bool>& stop, bool printInfo) {
+    auto start = std::chrono::steady_clock::now();
+    int helperCount = searchThreads - 1;
+    tt.newSearch();
+    prepareSearchContexts(helperCount + 1);
+    // The Board is only read here: every thread searches its own BBC-style copy
+    for (int id = 0; id <= helperCount; ++id)
+        contexts[id]->setRoot(board);
+    std::vector<BBCStyleEngine::Move> rootMoves = generateRootMoves(*contexts[0]);
+    if (rootMoves.empty())
+        return 0;
+    auto sameMove = [](BBCStyleEngine::Move move) {
+        return [move](const BBCStyleEngine::Move& m) { return m.data == move.data; };
+    };
+    int lastDepth = maxDepth > 0 ? std::min(maxDepth, MAX_SEARCH_DEPTH)
+                                 : MAX_SEARCH_DEPTH;
+
+    std::atomic<bool> helpersStop(false);
+    std::vector<std::future<void>> helpers;
+    helpers.reserve(helperCount);
+    for (int id = 1; id <= helperCount; ++id) {
+        helpers.emplace_back(pool.enqueue([&, id]() {
+            SearchContext& ctx = *contexts[id];
+            std::vector<BBCStyleEngine::Move> moves = rootMoves;
+            int skip = (id - 1) % 20;
+            int score = 0;
+            for (int depth = 1; depth <= lastDepth && !helpersStop; ++depth) {
+                if (((depth + SKIP_PHASE[skip]) / SKIP_SIZE[skip]) % 2)
+                    continue;
+                RootResult res = aspirationSearch(ctx, moves, depth, score, end,
+                                                  helpersStop);
+                if (!res.complete)
+                    break;
+                score = res.score;
+                auto it = std::find_if(moves.begin(), moves.end(),
+                                       sameMove(res.move));
+                if (it != moves.end())
+                    std::rotate(moves.begin(), it, it + 1);
             }
-            first = false;
-            board.unmakeMove(state);
+        }));
+    }
+
+    std::vector<BBCStyleEngine::Move> moves = rootMoves;
+    uint16_t completedMove = 0; // best move from the last fully searched depth
+    uint16_t partialMove = 0;
+    int score = 0;
+    for (int depth = 1; depth <= lastDepth; ++depth) {
+        RootResult res = aspirationSearch(*contexts[0], moves, depth, score, end, stop);
+        if (!res.complete) {
+            if (!completedMove && res.move.data)
+                partialMove = bbcMoveToUint16(res.move);
+            break;
         }
-        TTEntry save{depth, bestEval, 0, bestMove};
-        if (bestEval <= alphaOrig) save.flag = -1;
-        else if (bestEval >= beta) save.flag = 1;
-        tt.store(key, save);
-        return {bestEval, bestPV};
-    } else {
-        int bestEval = 1000000;
-        uint16_t bestMove = 0;
-        std::string bestPV;
-        bool first = true;
-        for (auto m : moves) {
-            bool capture = isCaptureMove(board, m);
-            int from = moveFrom(m);
-            int to = moveTo(m);
-            int plySide = board.isWhiteToMove() ? 0 : 1;
-            Board::MoveState state;
-            board.makeMove(m, state);
-            std::pair<int, std::string> child;
-            if (first) {
-                child = minimax(board, depth - 1, alpha, beta, true, end, stop, ply + 1);
+        completedMove = bbcMoveToUint16(res.move);
+        score = res.score;
+        auto it = std::find_if(moves.begin(), moves.end(), sameMove(res.move));
+        if (it != moves.end())
+            std::rotate(moves.begin(), it, it + 1);
+
+        if (printInfo) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+            int hashPercent = tt.hashfull();
+            uint64_t nodeCount = totalNodes();
+            uint64_t nps = elapsed > 0 ? (nodeCount * 1000 / elapsed) : nodeCount;
+            if (res.score >= MATE_BOUND || res.score <= -MATE_BOUND) {
+                int mateMoves = res.score > 0 ? (MATE - res.score + 1) / 2
+                                              : -(MATE + res.score) / 2;
+                std::cout << "info depth " << depth << " score mate " << mateMoves;
             } else {
-                child = minimax(board, depth - 1, beta - 1, beta,
-                                true, end, stop, ply + 1);
-                int eval = child.first;
-                if (eval < beta && eval > alpha) {
-                    child = minimax(board, depth - 1, alpha, eval,
-                                    true, end, stop, ply + 1);
-                }
-            }
-            int eval = child.first;
-            if (eval < bestEval) {
-                bestEval = eval;
-                bestMove = m;
-                bestPV = decodeMove(m);
-                if (!child.second.empty()) bestPV += " " + child.second;
+                std::cout << "info depth " << depth << " score cp " << res.score;
             }
-            if (eval < beta) {
-                beta = eval;
-                if (!capture)
-                    historyTable[plySide][from][to] += depth * depth;
-            }
-            if (beta <= alpha) {
-                if (!capture && ply < MAX_PLY) {
-                    if (killerMoves[ply][0] != m) {
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = m;
-                    }
-                }
-                board.unmakeMove(state);
-                break;
+            std::cout << " nodes " << nodeCount << " nps " << nps
+                      << " hashfull " << hashPercent << " time " << elapsed;
+            if (res.pvLength > 0) {
+                std::cout << " pv";
+                for (int i = 0; i < res.pvLength; ++i)
+                    std::cout << ' ' << toUCIMove(res.pv[i]);
             }
-            first = false;
-            board.unmakeMove(state);
+            std::cout << '\n';
         }
-        TTEntry save{depth, bestEval, 0, bestMove};
-        if (bestEval <= alphaOrig) save.flag = -1;
-        else if (bestEval >= beta) save.flag = 1;
-        tt.store(key, save);
-        return {bestEval, bestPV};
+        if (stop || std::chrono::steady_clock::now() >= end) break;
+    }
+
+    helpersStop = true;
+    for (auto& h : helpers)
+        h.get();
+
+    if (printInfo) {
+        auto researches = totalResearches();
+        std::cout << "info string aspiration re-searches fail high "
+                  << researches.first << " fail low " << researches.second << '\n';
+    }
+
+    if (completedMove)
+        return completedMove;
+    return partialMove ? partialMove : bbcMoveToUint16(rootMoves.front());
+}
+
+// -----------------------------------------------------------------------------
+// Makes sure there is a search context for every search thread and resets the
+// per-search state. Contexts are kept between searches and only created when
+// the number of threads grows.
+// -----------------------------------------------------------------------------
+void Engine::prepareSearchContexts(int count) {
+    while (static_cast<int>(contexts.size()) < count)
+        contexts.push_back(std::make_unique<SearchContext>());
+    for (int i = 0; i < count; ++i)
+        contexts[i]->newSearch();
+    for (size_t i = count; i < contexts.size(); ++i)
+        contexts[i]->resetCounters();
+}
+
+// -----------------------------------------------------------------------------
+// Sums the node counters of all search threads.
+// -----------------------------------------------------------------------------
+uint64_t Engine::totalNodes() const {
+    uint64_t total = 0;
+    for (const auto& ctx : contexts)
+        total += ctx->nodes.load(std::memory_order_relaxed);
+    return total;
+}
+
+// -----------------------------------------------------------------------------
+// Sums the aspiration re-searches of all search threads.
+// -----------------------------------------------------------------------------
+std::pair<uint64_t, uint64_t> Engine::totalResearches() const {
+    std::pair<uint64_t, uint64_t> total{0, 0};
+    for (const auto& ctx : contexts) {
+        total.first += ctx->failHighs.load(std::memory_order_relaxed);
+        total.second += ctx->failLows.load(std::memory_order_relaxed);
     }
+    return total;
 }
 
 // -----------------------------------------------------------------------------
@@ -527,56 +719,9 @@ std::string Engine::searchBestMove(Board& board, int depth) {
     }
 
     std::atomic<bool> dummyStop(false);
-    uint16_t bestMove = 0;
-
-    for (int d = 1; d <= depth; ++d) {
-        // Generate moves using BBC-style engine
-        boardToBBC(board, bbcEngine);
-        BBCStyleEngine::MoveList bbcMoves;
-        bbcEngine.generateMoves(bbcMoves);
-        
-        std::vector<uint16_t> moves;
-        for (int i = 0; i < bbcMoves.count; i++) {
-            uint16_t move = bbcMoveToUint16(bbcMoves.moves[i]);
-            if (board.isMoveLegal(move))
-                moves.push_back(move);
-        }
-        std::sort(moves.begin(), moves.end(), [&](uint16_t a, uint16_t b) {
-            return moveScore(board, a, bbcEngine) > moveScore(board, b, bbcEngine);
-        });
-        if (d > 1 && bestMove) {
-            auto it = std::find(moves.begin(), moves.end(), bestMove);
-            if (it != moves.end()) {
-                std::rotate(moves.begin(), it, it + 1);
-            }
-        }
-
-        int bestScore = board.isWhiteToMove() ? -1000000 : 1000000;
-        std::vector<std::future<std::pair<int, std::string>>> futures;
-        futures.reserve(moves.size());
-        for (auto m : moves) {
-            futures.emplace_back(pool.enqueue([&, m, d]() {
-                Board copy = board;
-                copy.makeMove(m);
-                return minimax(copy, d - 1, -1000000, 1000000,
-                               !board.isWhiteToMove(),
-                               std::chrono::steady_clock::time_point::max(),
-                               dummyStop, 0);
-            }));
-        }
-
-        for (size_t i = 0; i < moves.size(); ++i) {
-            auto res = futures[i].get();
-            int score = res.first;
-            uint16_t m = moves[i];
-            if (board.isWhiteToMove()) {
-                if (score > bestScore) { bestScore = score; bestMove = m; }
-            } else {
-                if (score < bestScore) { bestScore = score; bestMove = m; }
-            }
-        }
-    }
-
+    uint16_t bestMove = lazySmpSearch(
+        board, depth, std::chrono::steady_clock::time_point::max(),
+        dummyStop, false);
     return decodeMove(bestMove);
 }
 
@@ -601,111 +746,85 @@ std::string Engine::searchBestMoveTimed(Board& board, int maxDepth,
             return *bm;
     }
 
-    uint16_t bestMove = 0;
-    std::string bestPV;
-    uint16_t completedMove = 0; // best move from the last fully searched depth
-    int bestScore = 0;
-    bool lastDepthComplete = true;
-    for (int depth = 1; maxDepth == 0 || depth <= maxDepth; ++depth) {
-        nodes = 0;
-        auto depthStart = std::chrono::steady_clock::now();
-        
-        // Generate moves using BBC-style engine
-        boardToBBC(board, bbcEngine);
-        BBCStyleEngine::MoveList bbcMoves;
-        bbcEngine.generateMoves(bbcMoves);
-        
-        std::vector<uint16_t> moves;
-        for (int i = 0; i < bbcMoves.count; i++) {
-            uint16_t move = bbcMoveToUint16(bbcMoves.moves[i]);
-            if (board.isMoveLegal(move))
-                moves.push_back(move);
-        }
-        std::sort(moves.begin(), moves.end(), [&](uint16_t a, uint16_t b) {
-            return moveScore(board, a, bbcEngine) > moveScore(board, b, bbcEngine);
-        });
-        if (depth > 1 && completedMove) {
-            auto it = std::find(moves.begin(), moves.end(), completedMove);
-            if (it != moves.end()) {
-                std::rotate(moves.begin(), it, it + 1);
-            }
-        }
-        bestScore = board.isWhiteToMove() ? -1000000 : 1000000;
-        bestPV.clear();
-        lastDepthComplete = true;
-        std::vector<std::future<std::pair<int, std::string>>> futures;
-        futures.reserve(moves.size());
-        for (auto m : moves) {
-            futures.emplace_back(pool.enqueue([&, m]() {
-                Board copy = board;
-                copy.makeMove(m);
-                return minimax(copy, depth - 1, -1000000, 1000000,
-                               !board.isWhiteToMove(), endTime, stopFlag, 0);
-            }));
-        }
-        for (size_t i = 0; i < moves.size(); ++i) {
-            auto res = futures[i].get();
-            uint16_t m = moves[i];
-            int score = res.first;
-            std::string pvCandidate = decodeMove(m);
-            if (!res.second.empty()) pvCandidate += " " + res.second;
-            if (board.isWhiteToMove()) {
-                if (score > bestScore) { bestScore = score; bestMove = m; bestPV = pvCandidate; }
-            } else {
-                if (score < bestScore) { bestScore = score; bestMove = m; bestPV = pvCandidate; }
-            }
-            if (stopFlag || std::chrono::steady_clock::now() >= endTime)
-                lastDepthComplete = false;
-        }
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          std::chrono::steady_clock::now() - depthStart)
-                          .count();
-        std::string pvUCI;
-        int pvCount = 0;
-        {
-            std::istringstream iss(bestPV);
-            std::string token;
-            while (iss >> token) {
-                ++pvCount;
-                uint16_t mv = encodeMove(token);
-                if (!pvUCI.empty()) pvUCI += " ";
-                pvUCI += toUCIMove(mv);
-            }
-        }
-        int hashPercent = static_cast<int>(tt.used() * 1000 / tt.size());
-        uint64_t nodeCount = nodes.load();
-        uint64_t nps = elapsed > 0 ? (nodeCount * 1000 / elapsed) : nodeCount;
-        if (!lastDepthComplete) break;
-        int displayScore = board.isWhiteToMove() ? bestScore : -bestScore;
-        if (displayScore >= 900000 || displayScore <= -900000) {
-            int mateMoves = (pvCount + 1) / 2;
-            if (displayScore < 0) mateMoves = -mateMoves;
-            std::cout << "info depth " << depth << " score mate " << mateMoves
-                      << " nodes " << nodeCount << " nps " << nps
-                      << " hashfull " << hashPercent << " time " << elapsed;
-        } else {
-            std::cout << "info depth " << depth << " score cp " << displayScore
-                      << " nodes " << nodeCount << " nps " << nps
-                      << " hashfull " << hashPercent << " time " << elapsed;
-        }
-        if (!pvUCI.empty())
-            std::cout << " pv " << pvUCI;
-        std::cout << '\n';
-        completedMove = bestMove;
-        if (stopFlag || std::chrono::steady_clock::now() >= endTime) break;
-    }
-    if (completedMove)
-        return decodeMove(completedMove);
+    uint16_t bestMove = lazySmpSearch(board, maxDepth, endTime, stopFlag, true);
     return decodeMove(bestMove);
 }
 
 // -----------------------------------------------------------------------------
-// Resizes the transposition table to hold approximately the given number of
-// megabytes.
+// Resizes the transposition table to fill approximately the given number of
+// megabytes with clusters.
 // -----------------------------------------------------------------------------
 void Engine::setHashSizeMB(size_t mb) {
     size_t bytes = mb * 1024 * 1024;
-    size_t entries = bytes / sizeof(TTSlot);
-    if (entries == 0) entries = 1;
-    tt.resize(entries);
+    size_t clusters = bytes / sizeof(TranspositionTable::Cluster);
+    if (clusters == 0) clusters = 1;
+    tt.resize(clusters, &pool, searchThreads);
+}
+
+namespace {
+// Positions searched by bench: the opening, the usual perft test positions
+// and a quiet middlegame, so that both tactical and positional nodes count.
+const char* const BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+};
+
+// Clock used by bench. The time stamp counter ticks at a constant rate close
+// to the nominal clock whatever the core is doing, so it measures wall-clock
+// time, not core or stall cycles; without one, nanoseconds are counted.
+uint64_t tickCount() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+} // namespace
+
+// -----------------------------------------------------------------------------
+// Searches every bench position to a fixed depth on one thread, starting from
+// an empty scratch transposition table and fresh search contexts so that runs
+// are repeatable. The engine's own table and heuristics are swapped out for
+// the run and restored afterwards, so bench does not disturb a game or a
+// loaded hash snapshot. Ticks per node show how much of each node is spent
+// waiting on memory, which is what toggling the TT prefetch changes.
+// -----------------------------------------------------------------------------
+Engine::BenchResult Engine::bench(int depth) {
+    int threads = searchThreads;
+    searchThreads = 1;
+    TranspositionTable scratch;
+    tt.swap(scratch);
+    std::vector<std::unique_ptr<SearchContext>> saved;
+    contexts.swap(saved);
+
+    BenchResult result;
+    std::atomic<bool> noStop(false);
+    for (const char* fen : BENCH_FENS) {
+        Board board;
+        board.loadFEN(fen);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t ticks = tickCount();
+        lazySmpSearch(board, depth, std::chrono::steady_clock::time_point::max(),
+                      noStop, false);
+        ticks = tickCount() - ticks;
+        result.ms += std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start).count();
+        result.nodes += totalNodes();
+        auto researches = totalResearches();
+        result.failHighs += researches.first;
+        result.failLows += researches.second;
+        result.ticksPerNode += static_cast<double>(ticks);
+    }
+    if (result.nodes)
+        result.ticksPerNode /= static_cast<double>(result.nodes);
+    contexts.swap(saved);
+    tt.swap(scratch);
+    searchThreads = threads;
+    return result;
 }
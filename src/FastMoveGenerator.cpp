@@ -1,4 +1,5 @@
 #include "FastMoveGenerator.h"
+#include "Attacks.h"
 #include "Magic.h"
 #include "BitUtils.h"
 #include <cstring>
@@ -29,63 +30,6 @@ std::string FastMoveGenerator::Move::toAlgebraic() const {
     return result;
 }
 
-FastMoveGenerator::FastMoveGenerator() {
-    initAttackTables();
-}
-
-void FastMoveGenerator::initAttackTables() {
-    // Initialize knight attack table
-    const int knightOffsets[8][2] = {{1, 2}, {2, 1}, {-1, 2}, {-2, 1},
-                                     {1, -2}, {2, -1}, {-1, -2}, {-2, -1}};
-    
-    for (int sq = 0; sq < 64; ++sq) {
-        int rank = sq / 8;
-        int file = sq % 8;
-        
-        // Knight attacks
-        uint64_t knightMask = 0ULL;
-        for (auto& offset : knightOffsets) {
-            int newRank = rank + offset[1];
-            int newFile = file + offset[0];
-            if (newRank >= 0 && newRank < 8 && newFile >= 0 && newFile < 8) {
-                knightMask |= 1ULL << (newRank * 8 + newFile);
-            }
-        }
-        knightAttacks[sq] = knightMask;
-        
-        // King attacks
-        uint64_t kingMask = 0ULL;
-        for (int dr = -1; dr <= 1; ++dr) {
-            for (int df = -1; df <= 1; ++df) {
-                if (dr == 0 && df == 0) continue;
-                int newRank = rank + dr;
-                int newFile = file + df;
-                if (newRank >= 0 && newRank < 8 && newFile >= 0 && newFile < 8) {
-                    kingMask |= 1ULL << (newRank * 8 + newFile);
-                }
-            }
-        }
-        kingAttacks[sq] = kingMask;
-        
-        // Pawn attacks
-        // White pawn attacks (moving up the board)
-        uint64_t whitePawnMask = 0ULL;
-        if (rank < 7) { // Not on 8th rank
-            if (file > 0) whitePawnMask |= 1ULL << ((rank + 1) * 8 + file - 1); // Left capture
-            if (file < 7) whitePawnMask |= 1ULL << ((rank + 1) * 8 + file + 1); // Right capture
-        }
-        pawnAttacks[0][sq] = whitePawnMask; // White = 0
-        
-        // Black pawn attacks (moving down the board)
-        uint64_t blackPawnMask = 0ULL;
-        if (rank > 0) { // Not on 1st rank
-            if (file > 0) blackPawnMask |= 1ULL << ((rank - 1) * 8 + file - 1); // Left capture
-            if (file < 7) blackPawnMask |= 1ULL << ((rank - 1) * 8 + file + 1); // Right capture
-        }
-        pawnAttacks[1][sq] = blackPawnMask; // Black = 1
-    }
-}
-
 void FastMoveGenerator::generateMoves(const Board& board, bool isWhite, MoveList& moveList) const {
     moveList.clear();
     
@@ -171,7 +115,7 @@ bool FastMoveGenerator::isSquareAttacked(const Board& board, int square, bool by
     
     // Check knight attacks
     uint64_t knights = byWhite ? board.getWhiteKnights() : board.getBlackKnights();
-    if (knights & knightAttacks[square]) return true;
+    if (knights & Attacks::knight(square)) return true;
     
     // Check bishop/queen diagonal attacks
     uint64_t bishops = byWhite ? (board.getWhiteBishops() | board.getWhiteQueens()) : 
@@ -185,7 +129,7 @@ bool FastMoveGenerator::isSquareAttacked(const Board& board, int square, bool by
     
     // Check king attacks
     uint64_t king = byWhite ? board.getWhiteKing() : board.getBlackKing();
-    if (king & kingAttacks[square]) return true;
+    if (king & Attacks::king(square)) return true;
     
     return false;
 }
@@ -256,7 +200,7 @@ void FastMoveGenerator::generatePawnMoves(const Board& board, bool isWhite, Move
     // Captures
     while (pawns) {
         int from = lsbIndex(pawns);
-        uint64_t attacks = pawnAttacks[isWhite ? 0 : 1][from] & opponentPieces;
+        uint64_t attacks = Attacks::pawn(isWhite ? 0 : 1, from) & opponentPieces;
         
         while (attacks) {
             int to = lsbIndex(attacks);
@@ -283,7 +227,7 @@ void FastMoveGenerator::generatePawnMoves(const Board& board, bool isWhite, Move
         pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
         while (pawns) {
             int from = lsbIndex(pawns);
-            uint64_t enPassantMask = pawnAttacks[isWhite ? 0 : 1][from];
+            uint64_t enPassantMask = Attacks::pawn(isWhite ? 0 : 1, from);
             if (enPassantMask & (1ULL << enPassantSquare)) {
                 moveList.add(Move(from, enPassantSquare, 0, 0, true, false, true)); // En passant capture
             }
@@ -299,7 +243,7 @@ void FastMoveGenerator::generateKnightMoves(const Board& board, bool isWhite, Mo
     
     while (knights) {
         int from = lsbIndex(knights);
-        uint64_t attacks = knightAttacks[from] & ~ownPieces; // Can't capture own pieces
+        uint64_t attacks = Attacks::knight(from) & ~ownPieces; // Can't capture own pieces
         
         while (attacks) {
             int to = lsbIndex(attacks);
@@ -383,7 +327,7 @@ void FastMoveGenerator::generateKingMoves(const Board& board, bool isWhite, Move
     
     if (king) {
         int from = lsbIndex(king);
-        uint64_t attacks = kingAttacks[from] & ~ownPieces;
+        uint64_t attacks = Attacks::king(from) & ~ownPieces;
         
         while (attacks) {
             int to = lsbIndex(attacks);
@@ -521,7 +465,7 @@ bool FastMoveGenerator::isKingInCheckAfterMove(const Board& board, int kingSquar
     
     // Check knight attacks
     uint64_t enemyKnights = byWhite ? board.getWhiteKnights() : board.getBlackKnights();
-    if (enemyKnights & knightAttacks[kingSquare]) return true;
+    if (enemyKnights & Attacks::knight(kingSquare)) return true;
     
     // Check sliding piece attacks using the new occupancy
     uint64_t enemyBishopsQueens = byWhite ? (board.getWhiteBishops() | board.getWhiteQueens()) : 
@@ -534,7 +478,7 @@ bool FastMoveGenerator::isKingInCheckAfterMove(const Board& board, int kingSquar
     
     // Check king attacks
     uint64_t enemyKing = byWhite ? board.getWhiteKing() : board.getBlackKing();
-    if (enemyKing & kingAttacks[kingSquare]) return true;
+    if (enemyKing & Attacks::king(kingSquare)) return true;
     
     return false;
 }
@@ -45,7 +45,9 @@ public:
         void clear() { count = 0; }
     };
     
-    FastMoveGenerator();
+    // Attack tables are shared compile-time constants, so the generator is
+    // stateless and free to construct.
+    FastMoveGenerator() = default;
     
     // Generate all pseudo-legal moves
     void generateMoves(const Board& board, bool isWhite, MoveList& moveList) const;
@@ -71,12 +73,6 @@ public:
     bool isMoveLegal(const Board& board, const Move& move, bool isWhite) const;
     
 private:
-    // Pre-computed attack tables (like BBC)
-    uint64_t knightAttacks[64];
-    uint64_t kingAttacks[64];
-    uint64_t pawnAttacks[2][64]; // [color][square]
-    
-    void initAttackTables();
     
     // Fast legal move checking helpers  
     bool isMoveLegalDirect(const Board& board, const Move& move, bool isWhite, int kingSquare) const;
@@ -1,4 +1,5 @@
 #include "IncrementalBoard.h"
+#include "Attacks.h"
 #include "Magic.h"
 
 IncrementalBoard::IncrementalBoard(const Board& board) {
@@ -45,7 +46,8 @@ bool IncrementalBoard::isMoveLegal(int from, int to, int special, int promotion)
     applyMoveIncremental(from, to, special, promotion, state);
     
     // Quick check: Is our king in check? (BBC approach)
-    bool legal = !isKingInCheckFast(whiteToMove);
+    // The side has already been flipped, so ask about the mover's king.
+    bool legal = !isKingInCheckFast(state.originalWhiteToMove);
     
     // Rollback move (BBC-style fast restore)
     rollbackMove(state, from, to, special, promotion);
@@ -215,25 +217,12 @@ bool IncrementalBoard::isSquareAttackedFast(int square, bool byWhite) const {
     uint64_t allPieces = getAllPieces();
     
     // Check pawn attacks (BBC-style)
-    if (byWhite) {
-        int rank = square / 8;
-        int file = square % 8;
-        if (rank > 0) {
-            if (file > 0 && (whitePawns & (1ULL << ((rank - 1) * 8 + file - 1)))) return true;
-            if (file < 7 && (whitePawns & (1ULL << ((rank - 1) * 8 + file + 1)))) return true;
-        }
-    } else {
-        int rank = square / 8;
-        int file = square % 8;
-        if (rank < 7) {
-            if (file > 0 && (blackPawns & (1ULL << ((rank + 1) * 8 + file - 1)))) return true;
-            if (file < 7 && (blackPawns & (1ULL << ((rank + 1) * 8 + file + 1)))) return true;
-        }
-    }
+    uint64_t pawns = byWhite ? whitePawns : blackPawns;
+    if (pawns & Attacks::pawn(byWhite ? 1 : 0, square)) return true;
     
     // Check knight attacks  
     uint64_t knights = byWhite ? whiteKnights : blackKnights;
-    if (knights & Magic::getKnightAttacks(square)) return true;
+    if (knights & Attacks::knight(square)) return true;
     
     // Check bishop/queen diagonal attacks
     uint64_t bishops = byWhite ? (whiteBishops | whiteQueens) : (blackBishops | blackQueens);
@@ -245,7 +234,7 @@ bool IncrementalBoard::isSquareAttackedFast(int square, bool byWhite) const {
     
     // Check king attacks
     uint64_t king = byWhite ? whiteKing : blackKing;
-    if (king & Magic::getKingAttacks(square)) return true;
+    if (king & Attacks::king(square)) return true;
     
     return false;
 }
@@ -1,47 +1,41 @@
 #include "Magic.h"
+#include "Attacks.h"
 #include "BitUtils.h"
-#include <vector>
 #include <array>
-#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MAGIC_HAS_PEXT 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PEXT_TARGET
+#else
+#define PEXT_TARGET __attribute__((target("bmi2")))
+#endif
+#else
+#define MAGIC_HAS_PEXT 0
+#endif
 
 //------------------------------------------------------------------------------
-// Magic bitboard generation for sliding piece attacks. This module precomputes
-// masks, magic numbers and lookup tables for rooks and bishops to allow fast
-// move generation during search.
+// Magic bitboard lookups for sliding piece attacks. The magic numbers are
+// fixed constants, so masks, shifts and table offsets are all resolved at
+// compile time and every rook and bishop attack set lives in one contiguous
+// table.
 //------------------------------------------------------------------------------
 namespace Magic {
-    std::array<U64, 64> rookMasks{};
-    std::array<U64, 64> bishopMasks{};
-    std::array<U64, 64> rookMagics{};
-    std::array<U64, 64> bishopMagics{};
-    std::array<int, 64> rookShifts{};
-    std::array<int, 64> bishopShifts{};
-    std::array<std::vector<U64>, 64> rookTable{};
-    std::array<std::vector<U64>, 64> bishopTable{};
-    std::array<U64, 64> knightTable{};
-    std::array<U64, 64> kingTable{};
-    bool initialized = false;
-
     //------------------------------------------------------------------------------
     // Return the number of set bits in a 64-bit integer.
     //------------------------------------------------------------------------------
-    inline int popcount(U64 b) {
-        return popcount64(b);
-    }
-
-    //------------------------------------------------------------------------------
-    // Generate a pseudo-random 64-bit value used during magic number search.
-    //------------------------------------------------------------------------------
-    U64 random_u64() {
-        static std::mt19937_64 gen(42);
-        std::uniform_int_distribution<U64> dist(0, ~0ULL);
-        return dist(gen);
+    constexpr int popcount(U64 b) {
+        int count = 0;
+        for (; b; b &= b - 1) ++count;
+        return count;
     }
 
     //------------------------------------------------------------------------------
     // Compute the rook attack mask for the given square on an otherwise empty board.
     //------------------------------------------------------------------------------
-    U64 maskRook(int sq) {
+    constexpr U64 maskRook(int sq) {
         U64 mask = 0ULL;
         int r = sq / 8, f = sq % 8;
         for (int r1 = r + 1; r1 <= 6; ++r1) mask |= 1ULL << (r1 * 8 + f);
@@ -54,7 +48,7 @@ namespace Magic {
     //------------------------------------------------------------------------------
     // Compute the bishop attack mask for the given square on an otherwise empty board.
     //------------------------------------------------------------------------------
-    U64 maskBishop(int sq) {
+    constexpr U64 maskBishop(int sq) {
         U64 mask = 0ULL;
         int r = sq / 8, f = sq % 8;
         for (int r1 = r + 1, f1 = f + 1; r1 <= 6 && f1 <= 6; ++r1, ++f1)
@@ -111,150 +105,202 @@ namespace Magic {
     }
 
     //------------------------------------------------------------------------------
-    // Generate knight and king attack bitboards for a given square.
+    // Magic numbers, found by a random search (mt19937_64 seeded with 42).
     //------------------------------------------------------------------------------
-    U64 generateKnightAttacks(int sq) {
-        U64 p = 1ULL << sq;
-        U64 l1 = (p >> 1) & 0x7f7f7f7f7f7f7f7fULL;
-        U64 l2 = (p >> 2) & 0x3f3f3f3f3f3f3f3fULL;
-        U64 r1 = (p << 1) & 0xfefefefefefefefeULL;
-        U64 r2 = (p << 2) & 0xfcfcfcfcfcfcfcfcULL;
-        U64 h1 = l1 | r1;
-        U64 h2 = l2 | r2;
-        return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
-    }
-
-    U64 generateKingAttacks(int sq) {
-        U64 p = 1ULL << sq;
-        U64 attacks = (p << 8) | (p >> 8);
-        U64 lr = ((p << 1) & 0xfefefefefefefefeULL) | ((p >> 1) & 0x7f7f7f7f7f7f7f7fULL);
-        attacks |= lr;
-        attacks |= (lr << 8) | (lr >> 8);
-        return attacks;
-    }
+    constexpr U64 rookMagics[64] = {
+        0x0080006284104000ULL, 0x064000c590016000ULL, 0x8080200010008008ULL,
+        0x2080048008001001ULL, 0x0200040820220170ULL, 0x1300083214008100ULL,
+        0x6880010002004080ULL, 0x2080064080002900ULL, 0x0059800040002080ULL,
+        0x2102400220005000ULL, 0x0005002001004010ULL, 0x3040800800801000ULL,
+        0x0210800802040080ULL, 0x0044800200800400ULL, 0x5051000442000100ULL,
+        0x10090000a1000042ULL, 0x0000208000400080ULL, 0x3000290040010080ULL,
+        0x0025010010462000ULL, 0x0001010008100422ULL, 0x1000828004000800ULL,
+        0x0804008080040200ULL, 0x0410040002410810ULL, 0x8101020000409401ULL,
+        0x0020400080208000ULL, 0x0000802500400104ULL, 0x0000100480200080ULL,
+        0x5428084200201200ULL, 0x1218004040040200ULL, 0x0082000200049088ULL,
+        0x0098880400100201ULL, 0x0081800080004100ULL, 0x0830400080801020ULL,
+        0x0004200082804000ULL, 0x0010012802200400ULL, 0x0901100081800805ULL,
+        0xc884800800800402ULL, 0x3004800200800400ULL, 0x2040820804001001ULL,
+        0x10e81c0446000081ULL, 0x0000400088248000ULL, 0x0320002250024002ULL,
+        0x0029001020010040ULL, 0x0600081001010020ULL, 0x0203000408010012ULL,
+        0x1408040002008080ULL, 0x8404020810040001ULL, 0x200801a910420004ULL,
+        0x404000244c800180ULL, 0x4020304000890100ULL, 0x0030022000821880ULL,
+        0x0300100080080480ULL, 0x80a0040008008080ULL, 0x2004800200040080ULL,
+        0x2005000402000100ULL, 0x2002008401004200ULL, 0x880080102a004102ULL,
+        0x00002201c0550282ULL, 0x0a80081020010241ULL, 0x0200850108a01001ULL,
+        0x4022000804201002ULL, 0x0042001008040102ULL, 0x0291280b10019204ULL,
+        0x0000008900204406ULL,
+    };
 
-    //------------------------------------------------------------------------------
-    // Build an occupancy bitboard from an index and a list of attack squares.
-    //------------------------------------------------------------------------------
-    U64 setOccupancy(int index, int bits, const std::vector<int>& squares) {
-        U64 occ = 0ULL;
-        for (int i = 0; i < bits; ++i)
-            if (index & (1 << i))
-                occ |= 1ULL << squares[i];
-        return occ;
-    }
+    constexpr U64 bishopMagics[64] = {
+        0x0108021808030012ULL, 0x005010a101002161ULL, 0x2012440402200040ULL,
+        0x7d20a09080400002ULL, 0x000e0211188020b0ULL, 0x0000900420000002ULL,
+        0x209318013008281cULL, 0x0002004052282080ULL, 0x2000882058008500ULL,
+        0x00840404a0820205ULL, 0x0000105140450004ULL, 0x0126080841088024ULL,
+        0x1000508820000020ULL, 0x4000020804560000ULL, 0xa480040402029000ULL,
+        0xc610004100b05000ULL, 0x40202010041018e0ULL, 0x0090004401080904ULL,
+        0x0210001820802009ULL, 0x0000904802014000ULL, 0x0002000400a20100ULL,
+        0xc401021201013100ULL, 0x0014001200828820ULL, 0x0092088020820801ULL,
+        0x0020040009103482ULL, 0x0008200504610205ULL, 0x0080440848180210ULL,
+        0x3044010100200880ULL, 0x0014840020802004ULL, 0x240102020300d500ULL,
+        0x48010911044c1000ULL, 0x0000410022012101ULL, 0x0050042400323010ULL,
+        0x0048040420822800ULL, 0x000400240a08004cULL, 0x0840980800620a00ULL,
+        0x1004004200140108ULL, 0x0014010601044800ULL, 0x0008808110040102ULL,
+        0x4021010302012423ULL, 0x8082020240022120ULL, 0x0001080110000421ULL,
+        0x8020884050002800ULL, 0x00002a0124011200ULL, 0x8000022022001410ULL,
+        0x0040080800204040ULL, 0x003001a10d030400ULL, 0x100822004e080840ULL,
+        0x0022188e4840040aULL, 0x0000920801244003ULL, 0x0000aaa08430002cULL,
+        0x2000440442020000ULL, 0x404000c005010001ULL, 0x002c421022008010ULL,
+        0x6088520c48022401ULL, 0x5c20840400aa2040ULL, 0x1005050108a00c08ULL,
+        0x0800044c10841004ULL, 0x4050440022011002ULL, 0x0010004000420204ULL,
+        0x4200800040104120ULL, 0x2800004004083085ULL, 0x094908a801440400ULL,
+        0x2040082248802100ULL,
+    };
 
     //------------------------------------------------------------------------------
-    // Search for a suitable magic number for the given square and piece type.
+    // Per-square lookup data. Offsets index the shared attack table: rook
+    // entries come first, bishop entries follow them.
     //------------------------------------------------------------------------------
-    U64 findMagic(int sq, int bits, bool bishop) {
-        std::vector<int> squares;
-        U64 mask = bishop ? maskBishop(sq) : maskRook(sq);
-        for (U64 m = mask; m; m &= m - 1)
-            squares.push_back(lsbIndex(m));
+    struct Entry {
+        U64 mask;
+        U64 magic;
+        unsigned offset;
+        unsigned shift;
+    };
 
-        int size = 1 << bits;
-        std::vector<U64> occupancies(size), attacks(size);
-        for (int i = 0; i < size; ++i) {
-            occupancies[i] = setOccupancy(i, bits, squares);
-            attacks[i] = bishop ? bishopAttacksOnTheFly(sq, occupancies[i])
-                               : rookAttacksOnTheFly(sq, occupancies[i]);
+    constexpr std::array<Entry, 64> buildEntries(bool bishop, unsigned start) {
+        std::array<Entry, 64> entries{};
+        unsigned offset = start;
+        for (int sq = 0; sq < 64; ++sq) {
+            U64 mask = bishop ? maskBishop(sq) : maskRook(sq);
+            int bits = popcount(mask);
+            entries[sq] = {mask, bishop ? bishopMagics[sq] : rookMagics[sq],
+                           offset, unsigned(64 - bits)};
+            offset += 1u << bits;
         }
+        return entries;
+    }
+
+    constexpr unsigned tableEnd(const std::array<Entry, 64>& entries) {
+        return entries[63].offset + (1u << (64 - entries[63].shift));
+    }
 
-        while (true) {
-            U64 magic = random_u64() & random_u64() & random_u64();
+    constexpr std::array<Entry, 64> rookEntries = buildEntries(false, 0);
+    constexpr std::array<Entry, 64> bishopEntries =
+        buildEntries(true, tableEnd(rookEntries));
+    constexpr unsigned TABLE_SIZE = tableEnd(bishopEntries);
+    static_assert(TABLE_SIZE == 102400 + 5248, "unexpected slider table size");
 
-            if (popcount((mask * magic) & 0xFF00000000000000ULL) < 6) continue;
+    alignas(64) U64 attackTable[TABLE_SIZE];
 
-            std::vector<U64> used(size, 0ULL);
-            bool fail = false;
+    // Same layout indexed by PEXT of the occupancy instead of the magic
+    // product. Only filled when the CPU supports BMI2.
+    alignas(64) U64 pextTable[TABLE_SIZE];
 
-            for (int i = 0; i < size && !fail; ++i) {
-                int index = (int)((occupancies[i] * magic) >> (64 - bits));
-                if (!used[index])
-                    used[index] = attacks[i];
-                else if (used[index] != attacks[i])
-                    fail = true;
-            }
-            if (!fail)
-                return magic;
-        }
+    //------------------------------------------------------------------------------
+    // Check CPUID for BMI2 support.
+    //------------------------------------------------------------------------------
+    bool cpuHasBmi2() {
+#if MAGIC_HAS_PEXT && defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, 7, 0);
+        return (info[1] >> 8) & 1;
+#elif MAGIC_HAS_PEXT
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2");
+#else
+        return false;
+#endif
     }
 
+    const bool hasPext = cpuHasBmi2();
+    bool usePext = hasPext;
+
     //------------------------------------------------------------------------------
-    // Initialize magic numbers, masks, shifts and attack tables.
+    // Fill the attack tables for one piece type from its constant magics.
+    // Subsets of the mask are enumerated in counting order, which is exactly
+    // the PEXT index, so no BMI2 instruction is needed to build pextTable.
     //------------------------------------------------------------------------------
-    void init() {
-        if (initialized) return;
+    void fillTable(const std::array<Entry, 64>& entries, bool bishop) {
         for (int sq = 0; sq < 64; ++sq) {
-            rookMasks[sq] = maskRook(sq);
-            bishopMasks[sq] = maskBishop(sq);
-
-            knightTable[sq] = generateKnightAttacks(sq);
-            kingTable[sq] = generateKingAttacks(sq);
+            const Entry& e = entries[sq];
+            U64 occ = 0ULL;
+            unsigned subset = 0;
+            do {
+                U64 attacks = bishop ? bishopAttacksOnTheFly(sq, occ)
+                                     : rookAttacksOnTheFly(sq, occ);
+                attackTable[e.offset + ((occ * e.magic) >> e.shift)] = attacks;
+                if (hasPext)
+                    pextTable[e.offset + subset] = attacks;
+                occ = (occ - e.mask) & e.mask;  // next subset of the mask
+                ++subset;
+            } while (occ);
+        }
+    }
 
-            int rBits = popcount(rookMasks[sq]);
-            int bBits = popcount(bishopMasks[sq]);
-            rookShifts[sq] = 64 - rBits;
-            bishopShifts[sq] = 64 - bBits;
+    // The tables are filled once during static initialization; no magic
+    // search runs and no lookup has to check an initialization flag.
+    static const bool tableFilled =
+        (fillTable(rookEntries, false), fillTable(bishopEntries, true), true);
 
-            rookTable[sq].resize(1ULL << rBits);
-            bishopTable[sq].resize(1ULL << bBits);
+#if MAGIC_HAS_PEXT
+    PEXT_TARGET U64 pextLookup(const Entry& e, U64 occ) {
+        return pextTable[e.offset + _pext_u64(occ, e.mask)];
+    }
+#endif
 
-            rookMagics[sq] = findMagic(sq, rBits, false);
-            bishopMagics[sq] = findMagic(sq, bBits, true);
-        }
+    bool pextAvailable() { return hasPext; }
 
-        // Precompute attack tables
-        for (int sq = 0; sq < 64; ++sq) {
-            int rBits = popcount(rookMasks[sq]);
-            int bBits = popcount(bishopMasks[sq]);
-            std::vector<int> rSquares, bSquares;
-            for (U64 m = rookMasks[sq]; m; m &= m - 1) rSquares.push_back(lsbIndex(m));
-            for (U64 m = bishopMasks[sq]; m; m &= m - 1) bSquares.push_back(lsbIndex(m));
+    bool setBackend(Backend backend) {
+        if (backend == Backend::Pext && !hasPext)
+            return false;
+        usePext = backend == Backend::Pext;
+        return true;
+    }
 
-            for (int i = 0; i < (1 << rBits); ++i) {
-                U64 occ = setOccupancy(i, rBits, rSquares);
-                int index = (int)((occ * rookMagics[sq]) >> (64 - rBits));
-                rookTable[sq][index] = rookAttacksOnTheFly(sq, occ);
-            }
-            for (int i = 0; i < (1 << bBits); ++i) {
-                U64 occ = setOccupancy(i, bBits, bSquares);
-                int index = (int)((occ * bishopMagics[sq]) >> (64 - bBits));
-                bishopTable[sq][index] = bishopAttacksOnTheFly(sq, occ);
-            }
-        }
+    Backend getBackend() { return usePext ? Backend::Pext : Backend::Magic; }
 
-        initialized = true;
+    const char* backendName(Backend backend) {
+        return backend == Backend::Pext ? "pext" : "magic";
     }
 
+    //------------------------------------------------------------------------------
+    // Kept for callers that initialized the tables explicitly. The tables are
+    // ready before main() starts, so there is nothing left to do.
+    //------------------------------------------------------------------------------
+    void init() {}
+
     //------------------------------------------------------------------------------
     // Retrieve rook attack bitboard from the precomputed table.
     //------------------------------------------------------------------------------
     U64 getRookAttacks(int sq, U64 occ) {
-        U64 masked = occ & rookMasks[sq];
-        int index = (int)((masked * rookMagics[sq]) >> rookShifts[sq]);
-        return rookTable[sq][index];
+        const Entry& e = rookEntries[sq];
+#if MAGIC_HAS_PEXT
+        if (usePext) return pextLookup(e, occ);
+#endif
+        return attackTable[e.offset + (((occ & e.mask) * e.magic) >> e.shift)];
     }
 
     //------------------------------------------------------------------------------
     // Retrieve bishop attack bitboard from the precomputed table.
     //------------------------------------------------------------------------------
     U64 getBishopAttacks(int sq, U64 occ) {
-        U64 masked = occ & bishopMasks[sq];
-        int index = (int)((masked * bishopMagics[sq]) >> bishopShifts[sq]);
-        return bishopTable[sq][index];
+        const Entry& e = bishopEntries[sq];
+#if MAGIC_HAS_PEXT
+        if (usePext) return pextLookup(e, occ);
+#endif
+        return attackTable[e.offset + (((occ & e.mask) * e.magic) >> e.shift)];
     }
 
     //------------------------------------------------------------------------------
-    // Retrieve knight and king attack bitboards from precomputed tables.
+    // Retrieve knight and king attack bitboards from the shared leaper tables.
     //------------------------------------------------------------------------------
     U64 getKnightAttacks(int sq) {
-        return knightTable[sq];
+        return Attacks::knight(sq);
     }
 
     U64 getKingAttacks(int sq) {
-        return kingTable[sq];
+        return Attacks::king(sq);
     }
 
     //------------------------------------------------------------------------------
@@ -3,6 +3,16 @@
 namespace Magic {
     using U64 = uint64_t;
     void init();
+
+    // How slider lookups are indexed. Pext uses the BMI2 instruction and is
+    // selected at startup on CPUs that support it; Magic works everywhere.
+    // Change the backend only while no search or perft is running.
+    enum class Backend { Magic, Pext };
+    bool pextAvailable();
+    bool setBackend(Backend backend);  // false if the backend is unavailable
+    Backend getBackend();
+    const char* backendName(Backend backend);
+
     U64 getRookAttacks(int sq, U64 occ);
     U64 getBishopAttacks(int sq, U64 occ);
     U64 getKnightAttacks(int sq);
@@ -2,7 +2,7 @@
 #include "MoveEncoding.h"
 
 MoveGenerator::MoveGenerator() {
-    // FastMoveGenerator constructor handles initialization
+    // The fast generator only reads the shared attack tables
 }
 
 std::vector<uint16_t> MoveGenerator::convertMoves(const FastMoveGenerator::MoveList& moveList) const {
@@ -4,7 +4,6 @@
 #include <vector>
 #include <cstdint>
 #include <string>
-#include <memory>
 
 // Encoding move data
 #define MOVE(source, target) ((source) | ((target) << 6))
@@ -27,14 +26,9 @@ public:
     bool isKingInCheck(const Board& board, bool white) const;
 
 private:
-    mutable std::unique_ptr<FastMoveGenerator> fastGenerator;
+    FastMoveGenerator fastGenerator;
     
-    FastMoveGenerator& getFastGenerator() const {
-        if (!fastGenerator) {
-            fastGenerator = std::make_unique<FastMoveGenerator>();
-        }
-        return *fastGenerator;
-    }
+    const FastMoveGenerator& getFastGenerator() const { return fastGenerator; }
     
     // Helper function to convert FastMoveGenerator moves to uint16_t format
     std::vector<uint16_t> convertMoves(const FastMoveGenerator::MoveList& moveList) const;
@@ -0,0 +1,170 @@
+#include "MovePicker.h"
+#include "MVVLVA.h"
+#include "MoveEncoding.h"
+#include <utility>
+
+namespace {
+// History of the quiescence picker, which never reaches the quiet stage
+const int NO_HISTORY[64][64] = {};
+
+// Moves handed out by the capture stage
+bool isNoisy(const BBCStyleEngine::Move& move) {
+    return move.capture() || (move.promoted() && move.promoted() % 6 == Q);
+}
+
+// -----------------------------------------------------------------------------
+// MVV-LVA score of a capture or promotion. BBC piece codes modulo 6 are the
+// MVVLVA piece types; a queen promotion counts like winning a queen.
+// -----------------------------------------------------------------------------
+int captureScore(const BBCStyleEngine& pos, const BBCStyleEngine::Move& move) {
+    int score = 0;
+    if (move.capture()) {
+        int victimType = MVVLVA::Pawn;  // en passant
+        if (!move.enpass()) {
+            int first = pos.side == white ? p : P;
+            for (int piece = first; piece < first + 6; ++piece) {
+                if (get_bit(pos.bitboards[piece], move.target())) {
+                    victimType = piece % 6;
+                    break;
+                }
+            }
+        }
+        score = MVVLVA::Table[victimType][move.piece() % 6];
+    }
+    if (move.promoted() % 6 == Q)
+        score += MVVLVA::Table[MVVLVA::Queen][MVVLVA::Pawn];
+    return score;
+}
+} // namespace
+
+MovePicker::MovePicker(const BBCStyleEngine& pos, BBCStyleEngine::MoveList& buffer,
+                       uint16_t ttMove, const std::array<uint16_t, 2>& killers,
+                       const int (&history)[64][64])
+    : pos(pos), list(buffer), ttMove(ttMove), killers(killers), history(history) {
+    list.count = 0;
+}
+
+MovePicker::MovePicker(const BBCStyleEngine& pos, BBCStyleEngine::MoveList& buffer,
+                       uint16_t ttMove)
+    : pos(pos), list(buffer), ttMove(ttMove), killers{}, history(NO_HISTORY),
+      capturesOnly(true), seeThreshold(0) {
+    list.count = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Rebuilds the BBC move for a compact move of the side to move. The result
+// still has to pass isPseudoLegal, since the compact move may come from
+// another position with the same table slot or killer ply.
+// -----------------------------------------------------------------------------
+BBCStyleEngine::Move MovePicker::fromCompact(uint16_t compact) const {
+    int from = moveFrom(compact);
+    int to = moveTo(compact);
+    int first = pos.side == white ? P : p;
+    int piece = -1;
+    for (int pc = first; pc < first + 6; ++pc) {
+        if (get_bit(pos.bitboards[pc], from)) {
+            piece = pc;
+            break;
+        }
+    }
+    if (piece < 0) return BBCStyleEngine::Move();
+    bool pawn = piece == first;
+    bool enpass = pawn && to == pos.enpassant && from % 8 != to % 8;
+    bool capture = get_bit(pos.occupancies[pos.side ^ 1], to) || enpass;
+    bool doublePush = pawn && (to - from == 16 || from - to == 16);
+    int promoted = moveSpecial(compact) == 1 ? first + movePromotion(compact) + 1 : 0;
+    return BBCStyleEngine::Move(from, to, piece, promoted, capture, doublePush,
+                                enpass, moveSpecial(compact) == 3);
+}
+
+bool MovePicker::isKiller(uint16_t compact) const {
+    return compact == killers[0] || compact == killers[1];
+}
+
+// -----------------------------------------------------------------------------
+// Moves the highest scored remaining move of the stage to the front of the
+// unpicked range and returns its index.
+// -----------------------------------------------------------------------------
+int MovePicker::pickBest() {
+    int best = current;
+    for (int i = current + 1; i < list.count; ++i)
+        if (scores[i] > scores[best]) best = i;
+    std::swap(list.moves[current], list.moves[best]);
+    std::swap(scores[current], scores[best]);
+    return current++;
+}
+
+bool MovePicker::next(BBCStyleEngine::Move& move) {
+    switch (stage) {
+    case TTMove:
+        stage = GenerateCaptures;
+        if (ttMove) {
+            move = fromCompact(ttMove);
+            if ((!capturesOnly || isNoisy(move)) && pos.isPseudoLegal(move))
+                return true;
+            ttMove = 0;
+        }
+        [[fallthrough]];
+    case GenerateCaptures:
+        current = list.count;
+        pos.generateCaptures(list);
+        for (int i = current; i < list.count; ++i)
+            scores[i] = captureScore(pos, list.moves[i]);
+        stage = Captures;
+        [[fallthrough]];
+    case Captures:
+        while (current < list.count) {
+            int index = pickBest();
+            move = list.moves[index];
+            if (bbcMoveToUint16(move) == ttMove) continue;
+            if (pos.seeGE(move, seeThreshold)) return true;
+            // Already picked moves are done with, so the losing capture can
+            // take the place of one of them
+            std::swap(list.moves[badCaptures++], list.moves[index]);
+        }
+        if (capturesOnly) {
+            stage = Done;
+            return false;
+        }
+        stage = Killers;
+        [[fallthrough]];
+    case Killers:
+        while (killerIndex < 2) {
+            uint16_t& killer = killers[killerIndex++];
+            if (killer && killer != ttMove && !(killerIndex == 2 && killer == killers[0])) {
+                move = fromCompact(killer);
+                if (!isNoisy(move) && pos.isPseudoLegal(move)) return true;
+            }
+            // Not handed out here, so the quiet stage must not skip it
+            killer = 0;
+        }
+        stage = GenerateQuiets;
+        [[fallthrough]];
+    case GenerateQuiets:
+        current = list.count;
+        pos.generateQuiets(list);
+        for (int i = current; i < list.count; ++i)
+            scores[i] = history[list.moves[i].source()][list.moves[i].target()];
+        stage = Quiets;
+        [[fallthrough]];
+    case Quiets:
+        while (current < list.count) {
+            move = list.moves[pickBest()];
+            uint16_t compact = bbcMoveToUint16(move);
+            if (compact != ttMove && !isKiller(compact)) return true;
+        }
+        stage = BadCaptures;
+        current = 0;
+        [[fallthrough]];
+    case BadCaptures:
+        if (current < badCaptures) {
+            move = list.moves[current++];
+            return true;
+        }
+        stage = Done;
+        [[fallthrough]];
+    case Done:
+        break;
+    }
+    return false;
+}
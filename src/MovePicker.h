@@ -0,0 +1,79 @@
+#pragma once
+#include "BBCStyleEngine.h"
+#include <array>
+#include <cstdint>
+
+// Converts a BBC move to the compact uint16_t format used by the
+// transposition table, the killer and history heuristics and the UCI layer
+inline uint16_t bbcMoveToUint16(const BBCStyleEngine::Move& bbcMove) {
+    int from = bbcMove.source();
+    int to = bbcMove.target();
+    int special = 0;
+    int promo = 0;
+
+    if (bbcMove.castling()) special = 3;
+    else if (bbcMove.promoted()) {
+        special = 1;
+        promo = (bbcMove.promoted() % 6) - 1;  // N, B, R, Q -> 0..3
+    }
+
+    return (to & 0x3f) | ((from & 0x3f) << 6) | ((promo & 0x3) << 12) |
+           ((special & 0x3) << 14);
+}
+
+// -----------------------------------------------------------------------------
+// Hands out the moves of a node one at a time in stages:
+//
+//   1. the transposition table move
+//   2. captures and queen promotions that do not lose material by static
+//      exchange evaluation, best MVV-LVA score first
+//   3. the two killer moves
+//   4. the remaining quiet moves, best history score first
+//   5. the losing captures put aside in stage 2
+//
+// The quiescence constructor stops after stage 2 and drops the losing
+// captures, so that only the TT move and captures with a non-negative static
+// exchange are handed out.
+//
+// Each stage generates its moves only when it is reached and picks them by
+// partial selection, so a node that is cut off by the TT move or a capture
+// never generates or scores a quiet move. Moves are pseudo-legal; the search
+// still rejects those that leave the king in check through makeMove.
+// -----------------------------------------------------------------------------
+class MovePicker {
+public:
+    // Captures losing less than this are still searched early, so that
+    // bishop for knight trades are not deferred
+    static constexpr int GOOD_CAPTURE_THRESHOLD = -50;
+
+    MovePicker(const BBCStyleEngine& pos, BBCStyleEngine::MoveList& buffer,
+               uint16_t ttMove, const std::array<uint16_t, 2>& killers,
+               const int (&history)[64][64]);
+    // Captures only, for quiescence search
+    MovePicker(const BBCStyleEngine& pos, BBCStyleEngine::MoveList& buffer,
+               uint16_t ttMove);
+
+    // Returns false once every move has been handed out
+    bool next(BBCStyleEngine::Move& move);
+
+private:
+    enum Stage { TTMove, GenerateCaptures, Captures, Killers,
+                 GenerateQuiets, Quiets, BadCaptures, Done };
+
+    const BBCStyleEngine& pos;
+    BBCStyleEngine::MoveList& list;  // per-ply buffer of the search context
+    uint16_t ttMove;                  // cleared when not playable here
+    std::array<uint16_t, 2> killers;  // likewise
+    const int (&history)[64][64];
+    bool capturesOnly = false;
+    int seeThreshold = GOOD_CAPTURE_THRESHOLD;
+    Stage stage = TTMove;
+    int current = 0;       // next unpicked move of the current stage
+    int killerIndex = 0;
+    int badCaptures = 0;   // losing captures are kept at the front of the list
+    int scores[256];
+
+    BBCStyleEngine::Move fromCompact(uint16_t compact) const;
+    bool isKiller(uint16_t compact) const;
+    int pickBest();
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include "BBCStyleEngine.h"
+#include "Board.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Per-thread search state. The engine creates one context for every search
+// thread and keeps it alive between iterations and between searches, so the
+// search never shares mutable state with another thread and does not pay any
+// setup cost per call.
+struct SearchContext {
+    static constexpr int MAX_PLY = 128;
+
+    // Private search board (never shared between threads). The search plays
+    // moves on it with copyBoard/makeMove/takeBack.
+    BBCStyleEngine bbc;
+
+    // Move ordering heuristics
+    std::array<std::array<uint16_t, 2>, MAX_PLY> killerMoves{};
+    int historyTable[2][64][64]{};
+
+    // Per-ply buffers so that nodes do not allocate while searching
+    std::array<BBCStyleEngine::MoveList, MAX_PLY> moveLists;
+
+    // Triangular principal variation table: pv[ply][ply..pvLength[ply]) is the
+    // best line found from the node at ply
+    uint16_t pv[MAX_PLY][MAX_PLY]{};
+    int pvLength[MAX_PLY]{};
+
+    // Zobrist keys of the game before the root followed by the positions on
+    // the current search path: keyStack[rootIndex + ply] is the key at ply
+    std::array<uint64_t, Board::KEY_HISTORY_SIZE + MAX_PLY> keyStack{};
+    int rootIndex = 0;
+
+    // Null move is not tried below this ply while a null move cutoff is being
+    // verified
+    int nullMoveMinPly = 0;
+
+    // Node counter written only by the owning thread and read by the main
+    // thread for UCI reporting
+    std::atomic<uint64_t> nodes{0};
+
+    // Root iterations repeated because the score fell outside the aspiration
+    // window, counted like the nodes
+    std::atomic<uint64_t> failHighs{0};
+    std::atomic<uint64_t> failLows{0};
+
+    void countNode() {
+        nodes.store(nodes.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    void countResearch(bool failHigh) {
+        std::atomic<uint64_t>& counter = failHigh ? failHighs : failLows;
+        counter.store(counter.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    }
+
+    void resetCounters() {
+        nodes.store(0, std::memory_order_relaxed);
+        failHighs.store(0, std::memory_order_relaxed);
+        failLows.store(0, std::memory_order_relaxed);
+    }
+
+    // Makes move followed by the child's line the principal variation at ply
+    void updatePV(int ply, uint16_t move) {
+        pv[ply][ply] = move;
+        int childLength = pvLength[ply + 1];
+        for (int i = ply + 1; i < childLength; ++i)
+            pv[ply][i] = pv[ply + 1][i];
+        pvLength[ply] = std::max(childLength, ply + 1);
+    }
+
+    // Loads the root position together with its game history, so that the
+    // search also recognises repetitions of positions played before the root.
+    void setRoot(const Board& board) {
+        bbc.loadFromBoard(board);
+        const uint64_t* keys = board.getKeyHistory();
+        int size = board.getKeyHistorySize();
+        rootIndex = size > 0 ? size - 1 : 0;
+        std::copy(keys, keys + rootIndex, keyStack.begin());
+        keyStack[rootIndex] = bbc.hashKey;
+    }
+
+    // Prepares the context for a new search: killers refer to positions of the
+    // previous search so they are dropped, while history is only aged.
+    void newSearch() {
+        for (auto& km : killerMoves) km[0] = km[1] = 0;
+        nullMoveMinPly = 0;
+        for (auto& side : historyTable)
+            for (auto& from : side)
+                for (auto& value : from)
+                    value /= 2;
+        resetCounters();
+    }
+};
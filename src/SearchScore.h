@@ -0,0 +1,10 @@
+#pragma once
+
+// Search scores shared by the engine and the transposition table. Scores are
+// centipawns for the side to move; being mated at ply n scores -(MATE - n).
+namespace SearchScore {
+
+inline constexpr int MATE = 1000000;
+inline constexpr int MATE_BOUND = 900000;  // scores beyond are mates
+
+} // namespace SearchScore
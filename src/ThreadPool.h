@@ -15,6 +15,8 @@ public:
     template<class F>
     auto enqueue(F&& f) -> std::future<typename std::invoke_result_t<F>>;
 
+    size_t size() const { return workers.size(); }
+
 private:
     std::vector<std::thread> workers;
     std::queue<std::function<void()>> tasks;
@@ -0,0 +1,275 @@
+// -----------------------------------------------------------------------------
+// Allocation and clearing of the transposition table. Large tables are backed
+// by anonymous memory mappings with transparent huge pages requested, which
+// the OS hands out already zeroed, so resizing does not touch every cluster.
+// Clearing an existing table is split across the engine's worker threads.
+// -----------------------------------------------------------------------------
+#include "TranspositionTable.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Below this many clusters a single thread clears faster than a hand-off.
+constexpr size_t PARALLEL_CLEAR_MIN = 1 << 16;
+
+// Clusters inspected to estimate how full the table is.
+constexpr size_t HASHFULL_SAMPLE = 1000;
+
+// Snapshot file layout: the header, zero padding up to SNAPSHOT_DATA_OFFSET
+// and then the clusters exactly as they are laid out in memory. The offset is
+// a multiple of the page size and of the Windows allocation granularity, so
+// the clusters can be mapped straight from the file.
+constexpr char SNAPSHOT_MAGIC[8] = {'A', 'P', 'H', 'E', 'L', 'T', 'T', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr size_t SNAPSHOT_DATA_OFFSET = 64 * 1024;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t generation;
+    uint64_t clusterSize;
+    uint64_t clusterCount;
+};
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t clusterCount) {
+    if (!allocate(clusterCount))
+        clear();
+}
+
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+// -----------------------------------------------------------------------------
+// Reserves memory for the given number of clusters. Returns true when the
+// memory is known to be zero-filled already.
+// -----------------------------------------------------------------------------
+bool TranspositionTable::allocate(size_t clusters) {
+    if (clusters == 0) clusters = 1;
+    size_t bytes = clusters * sizeof(Cluster);
+    clusterCount = clusters;
+#if defined(__linux__)
+    // Over-map by one huge page so the table can start on a 2 MB boundary,
+    // then return the unused head and tail to the kernel.
+    size_t size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void* raw = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED) {
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (aligned > start)
+            munmap(raw, aligned - start);
+        size_t tail = start + size + HUGE_PAGE_SIZE - (aligned + size);
+        if (tail)
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+#if defined(MADV_HUGEPAGE)
+        madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+        table = reinterpret_cast<Cluster*>(aligned);
+        allocatedBytes = size;
+        osAllocated = true;
+        fileMapped = false;
+        return true;
+    }
+#elif defined(_WIN32)
+    // Large pages need a privilege most users do not have, so ordinary
+    // committed pages are used; they are zeroed like the Linux mapping.
+    void* mem = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (mem) {
+        table = static_cast<Cluster*>(mem);
+        allocatedBytes = bytes;
+        osAllocated = true;
+        fileMapped = false;
+        return true;
+    }
+#endif
+    table = static_cast<Cluster*>(::operator new(bytes, std::align_val_t(alignof(Cluster))));
+    allocatedBytes = bytes;
+    osAllocated = false;
+    fileMapped = false;
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Returns the table memory to the system.
+// -----------------------------------------------------------------------------
+void TranspositionTable::release() {
+    if (!table) return;
+    if (osAllocated) {
+#if defined(__linux__)
+        munmap(table, allocatedBytes);
+#elif defined(_WIN32)
+        if (fileMapped)
+            UnmapViewOfFile(table);
+        else
+            VirtualFree(table, 0, MEM_RELEASE);
+#endif
+    } else {
+        ::operator delete(table, std::align_val_t(alignof(Cluster)));
+    }
+    table = nullptr;
+    clusterCount = 0;
+    allocatedBytes = 0;
+    fileMapped = false;
+}
+
+void TranspositionTable::resize(size_t clusters, ThreadPool* pool, int threads) {
+    release();
+    if (!allocate(clusters))
+        clear(pool, threads);
+}
+
+void TranspositionTable::clear(ThreadPool* pool, int threads) {
+    size_t workers = pool ? std::min<size_t>(std::max(threads, 1), pool->size() + 1) : 1;
+    if (clusterCount < PARALLEL_CLEAR_MIN) workers = 1;
+    size_t chunk = (clusterCount + workers - 1) / workers;
+    auto clearRange = [this](size_t begin, size_t end) {
+        if (begin < end)
+            std::memset(static_cast<void*>(table + begin), 0,
+                        (end - begin) * sizeof(Cluster));
+    };
+
+    // The calling thread takes the first chunk, the pool the rest
+    std::vector<std::future<void>> parts;
+    for (size_t i = 1; i < workers; ++i) {
+        size_t begin = std::min(clusterCount, i * chunk);
+        size_t end = std::min(clusterCount, begin + chunk);
+        parts.push_back(pool->enqueue([=] { clearRange(begin, end); }));
+    }
+    clearRange(0, std::min(clusterCount, chunk));
+    for (auto& part : parts) part.get();
+}
+
+// -----------------------------------------------------------------------------
+// Counts the current-generation entries among the first clusters. Keys spread
+// uniformly over the table, so the sample is representative, and reading it
+// costs nothing on the store path.
+// -----------------------------------------------------------------------------
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min(clusterCount, HASHFULL_SAMPLE);
+    size_t filled = 0;
+    for (size_t i = 0; i < sample; ++i)
+        for (const Slot& slot : table[i].entries) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if (bound(data) != 0 && age(data) == 0)
+                ++filled;
+        }
+    return sample ? static_cast<int>(filled * 1000 / (sample * CLUSTER_SIZE)) : 0;
+}
+
+// -----------------------------------------------------------------------------
+// Writes the table to a temporary file and renames it over the target, so a
+// snapshot that is currently mapped by load() is never truncated under it.
+// -----------------------------------------------------------------------------
+bool TranspositionTable::save(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.generation = generation;
+        header.clusterSize = sizeof(Cluster);
+        header.clusterCount = clusterCount;
+        std::vector<char> padding(SNAPSHOT_DATA_OFFSET - sizeof(header), 0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        out.write(reinterpret_cast<const char*>(table),
+                  static_cast<std::streamsize>(clusterCount * sizeof(Cluster)));
+        if (!out.flush()) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool TranspositionTable::load(const std::string& path) {
+    SnapshotHeader header{};
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION ||
+        header.clusterSize != sizeof(Cluster) || header.clusterCount == 0 ||
+        fileSize < SNAPSHOT_DATA_OFFSET ||
+        header.clusterCount > (fileSize - SNAPSHOT_DATA_OFFSET) / sizeof(Cluster))
+        return false;
+    size_t clusters = static_cast<size_t>(header.clusterCount);
+    size_t bytes = clusters * sizeof(Cluster);
+
+#if defined(__linux__)
+    // A private mapping: entries stored by the search stay in memory and
+    // never write back to the snapshot.
+    in.close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                     static_cast<off_t>(SNAPSHOT_DATA_OFFSET));
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+    release();
+    table = static_cast<Cluster*>(mem);
+    allocatedBytes = bytes;
+    osAllocated = true;
+    fileMapped = true;
+#elif defined(_WIN32)
+    in.close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+    uint64_t offset = SNAPSHOT_DATA_OFFSET;
+    void* mem = MapViewOfFile(mapping, FILE_MAP_COPY, static_cast<DWORD>(offset >> 32),
+                              static_cast<DWORD>(offset), bytes);
+    CloseHandle(mapping);
+    if (!mem) return false;
+    release();
+    table = static_cast<Cluster*>(mem);
+    allocatedBytes = bytes;
+    osAllocated = true;
+    fileMapped = true;
+#else
+    Cluster* mem = static_cast<Cluster*>(
+        ::operator new(bytes, std::align_val_t(alignof(Cluster))));
+    in.seekg(static_cast<std::streamoff>(SNAPSHOT_DATA_OFFSET));
+    if (!in.read(reinterpret_cast<char*>(mem), static_cast<std::streamsize>(bytes))) {
+        ::operator delete(mem, std::align_val_t(alignof(Cluster)));
+        return false;
+    }
+    release();
+    table = mem;
+    allocatedBytes = bytes;
+    osAllocated = false;
+#endif
+    clusterCount = clusters;
+    generation = static_cast<uint8_t>(header.generation & 0x3f);
+    return true;
+}
@@ -1,7 +1,15 @@
 #pragma once
+#include "SearchScore.h"
 #include <cstdint>
+#include <algorithm>
 #include <atomic>
-#include <vector>
+#include <string>
+#include <utility>
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+class ThreadPool;
 
 struct TTEntry {
     int depth;
@@ -10,64 +18,212 @@ struct TTEntry {
     uint16_t move{0};
 };
 
-struct TTSlot {
-    std::atomic<uint64_t> key{0};
-    std::atomic<int> depth{-1};
-    std::atomic<int> value{0};
-    std::atomic<int> flag{0};
-    std::atomic<uint16_t> move{0};
-};
-
+// -----------------------------------------------------------------------------
+// Transposition table made of small buckets ("clusters"). Every entry is two
+// 64-bit words: the data, and the Zobrist key XORed with the data.
+//
+//   data bits  0-15  move
+//   data bits 16-31  score
+//   data bits 32-39  depth
+//   data bits 40-41  bound (0 = empty slot)
+//   data bits 42-47  generation
+//
+// A probe only accepts an entry whose two words XOR back to the probed key.
+// When threads race on a slot and a reader sees the key word of one store
+// and the data word of another, the check fails and the entry is ignored.
+// No locks are taken and each word is a plain relaxed atomic.
+//
+// A cluster holds four entries in one 64-byte cache line. The high bits of
+// the key select the cluster through a multiply-high reduction, which works
+// for any table size.
+// -----------------------------------------------------------------------------
 class TranspositionTable {
 public:
-    explicit TranspositionTable(size_t size = DEFAULT_SIZE)
-        : table(size), usedSlots(0) {}
+    static constexpr int CLUSTER_SIZE = 4;
 
-    void resize(size_t newSize) {
-        std::vector<TTSlot> newTable(newSize);
-        table.swap(newTable);
-        usedSlots.store(0, std::memory_order_relaxed);
-    }
+    struct Slot {
+        std::atomic<uint64_t> key;   // Zobrist key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Cluster {
+        Slot entries[CLUSTER_SIZE];
+    };
 
-    size_t size() const { return table.size(); }
+    explicit TranspositionTable(size_t clusterCount = DEFAULT_CLUSTERS);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
 
-    size_t used() const { return usedSlots.load(std::memory_order_relaxed); }
+    // Reallocates the table with the given number of clusters. Fresh memory
+    // comes zeroed from the OS where possible; otherwise it is cleared with
+    // up to `threads` workers of the pool.
+    void resize(size_t clusterCount, ThreadPool* pool = nullptr, int threads = 1);
+
+    // Capacity in entries
+    size_t size() const { return clusterCount * CLUSTER_SIZE; }
+
+    // Permille of entries written during the current search, estimated from
+    // the first clusters of the table as the UCI hashfull field expects
+    int hashfull() const;
+
+    // -------------------------------------------------------------------------
+    // Starts a new search generation. Entries from earlier searches stay
+    // probeable but are replaced first, so the table keeps its useful
+    // content across moves of a game without being cleared.
+    // -------------------------------------------------------------------------
+    void newSearch() {
+        generation = static_cast<uint8_t>((generation + 1) & 0x3f);
+    }
 
     void store(uint64_t key, const TTEntry& entry) {
-        auto& slot = table[key % table.size()];
-        int curDepth = slot.depth.load(std::memory_order_relaxed);
-        if (curDepth <= entry.depth) {
-            if (curDepth == -1) {
-                usedSlots.fetch_add(1, std::memory_order_relaxed);
+        Cluster& cluster = table[clusterIndex(key)];
+
+        // Reuse the slot of the same position or an empty one; otherwise
+        // evict the shallowest entry. Every search of age counts as eight
+        // plies of depth, so stale deep entries eventually make room.
+        int victim = 0;
+        int victimWorth = 1 << 30;
+        uint64_t old = 0;
+        bool samePosition = false;
+        for (int i = 0; i < CLUSTER_SIZE; ++i) {
+            uint64_t data = cluster.entries[i].data.load(std::memory_order_relaxed);
+            uint64_t check = cluster.entries[i].key.load(std::memory_order_relaxed);
+            samePosition = (check ^ data) == key;
+            if (bound(data) == 0 || samePosition) {
+                victim = i;
+                old = data;
+                break;
+            }
+            int worth = depthOf(data) - 8 * age(data);
+            if (worth < victimWorth) {
+                victimWorth = worth;
+                victim = i;
+                old = data;
             }
-            slot.key.store(key, std::memory_order_relaxed);
-            slot.depth.store(entry.depth, std::memory_order_relaxed);
-            slot.value.store(entry.value, std::memory_order_relaxed);
-            slot.flag.store(entry.flag, std::memory_order_relaxed);
-            slot.move.store(entry.move, std::memory_order_relaxed);
         }
+
+        uint16_t move = entry.move;
+        if (samePosition && bound(old) != 0) {
+            // Keep a deeper result from this search and never lose the
+            // known best move.
+            if (entry.move == 0) move = moveOf(old);
+            if (age(old) == 0 && entry.depth < depthOf(old) && entry.flag != 0)
+                return;
+        }
+        uint64_t data = pack(move, entry);
+        cluster.entries[victim].key.store(key ^ data, std::memory_order_relaxed);
+        cluster.entries[victim].data.store(data, std::memory_order_relaxed);
     }
 
-    bool probe(uint64_t key, TTEntry& entry) const {
-        const auto& slot = table[key % table.size()];
-        if (slot.depth.load(std::memory_order_relaxed) == -1 ||
-            slot.key.load(std::memory_order_relaxed) != key) return false;
-        entry.depth = slot.depth.load(std::memory_order_relaxed);
-        entry.value = slot.value.load(std::memory_order_relaxed);
-        entry.flag = slot.flag.load(std::memory_order_relaxed);
-        entry.move = slot.move.load(std::memory_order_relaxed);
-        return true;
+    // -------------------------------------------------------------------------
+    // Starts loading the cluster of a position that is about to be probed, so
+    // the cache miss overlaps with the work done before the probe.
+    // -------------------------------------------------------------------------
+    void prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&table[clusterIndex(key)]);
+#elif defined(_MSC_VER)
+        _mm_prefetch(reinterpret_cast<const char*>(&table[clusterIndex(key)]), _MM_HINT_T0);
+#endif
     }
 
-    void clear() {
-        for (auto& s : table) {
-            s.depth.store(-1, std::memory_order_relaxed);
-            s.move.store(0, std::memory_order_relaxed);
+    bool probe(uint64_t key, TTEntry& entry) const {
+        const Cluster& cluster = table[clusterIndex(key)];
+        for (int i = 0; i < CLUSTER_SIZE; ++i) {
+            uint64_t check = cluster.entries[i].key.load(std::memory_order_relaxed);
+            uint64_t data = cluster.entries[i].data.load(std::memory_order_relaxed);
+            if (bound(data) == 0 || (check ^ data) != key) continue;
+            entry.depth = depthOf(data);
+            entry.value = scoreFromTT(static_cast<int16_t>(data >> 16));
+            entry.flag = boundToFlag(bound(data));
+            entry.move = moveOf(data);
+            return true;
         }
-        usedSlots.store(0, std::memory_order_relaxed);
+        return false;
     }
+
+    // Empties every entry, splitting the table across up to `threads`
+    // workers of the pool.
+    void clear(ThreadPool* pool = nullptr, int threads = 1);
+
+    // Exchanges the memory and generation of two tables, so that a search can
+    // run on a scratch table and leave this one untouched
+    void swap(TranspositionTable& other) noexcept {
+        std::swap(table, other.table);
+        std::swap(clusterCount, other.clusterCount);
+        std::swap(allocatedBytes, other.allocatedBytes);
+        std::swap(osAllocated, other.osAllocated);
+        std::swap(fileMapped, other.fileMapped);
+        std::swap(generation, other.generation);
+    }
+
+    // -------------------------------------------------------------------------
+    // Snapshots. save() writes a small header followed by the raw clusters;
+    // load() maps such a file copy-on-write in place of the current table, so
+    // even a multi-gigabyte table is usable at once and pages are read in as
+    // the search touches them. The table takes the size stored in the file.
+    // Both return false and leave the table unchanged on failure.
+    // -------------------------------------------------------------------------
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
 private:
-    static constexpr size_t DEFAULT_SIZE = 1 << 20;
-    std::vector<TTSlot> table;
-    std::atomic<size_t> usedSlots;
+    static constexpr size_t DEFAULT_CLUSTERS = 1 << 19;  // 32 MB
+
+    // Mate scores are folded into the top of the 16-bit range
+    static constexpr int MATE = SearchScore::MATE;
+    static constexpr int MATE_BOUND = SearchScore::MATE_BOUND;
+    static constexpr int TT_MATE = 32000;
+
+    Cluster* table = nullptr;
+    size_t clusterCount = 0;
+    size_t allocatedBytes = 0;
+    bool osAllocated = false;  // mapped pages rather than operator new
+    bool fileMapped = false;   // mapped from a snapshot file by load()
+    uint8_t generation = 0;
+
+    size_t clusterIndex(uint64_t key) const {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<size_t>(
+            (static_cast<unsigned __int128>(key) * clusterCount) >> 64);
+#else
+        return static_cast<size_t>(key % clusterCount);
+#endif
+    }
+
+    static uint16_t moveOf(uint64_t data) { return static_cast<uint16_t>(data); }
+    static int depthOf(uint64_t data) { return static_cast<int>((data >> 32) & 0xff); }
+    static int bound(uint64_t data) { return static_cast<int>((data >> 40) & 0x3); }
+    static int generationOf(uint64_t data) { return static_cast<int>((data >> 42) & 0x3f); }
+
+    bool allocate(size_t clusters);
+    void release();
+
+    int age(uint64_t data) const { return (generation - generationOf(data)) & 0x3f; }
+
+    static int flagToBound(int flag) { return flag == 0 ? 3 : (flag > 0 ? 2 : 1); }
+    static int boundToFlag(int b) { return b == 3 ? 0 : (b == 2 ? 1 : -1); }
+
+    static int16_t scoreToTT(int value) {
+        if (value >= MATE_BOUND)
+            return static_cast<int16_t>(32767 - std::min(MATE - value, 767));
+        if (value <= -MATE_BOUND)
+            return static_cast<int16_t>(-32767 + std::min(MATE + value, 767));
+        return static_cast<int16_t>(std::max(-TT_MATE + 1, std::min(TT_MATE - 1, value)));
+    }
+
+    static int scoreFromTT(int16_t stored) {
+        if (stored >= TT_MATE) return MATE - (32767 - stored);
+        if (stored <= -TT_MATE) return -MATE + (32767 + stored);
+        return stored;
+    }
+
+    uint64_t pack(uint16_t move, const TTEntry& entry) const {
+        int depth = std::max(0, std::min(255, entry.depth));
+        return static_cast<uint64_t>(move) |
+               static_cast<uint64_t>(static_cast<uint16_t>(scoreToTT(entry.value))) << 16 |
+               static_cast<uint64_t>(depth) << 32 |
+               static_cast<uint64_t>(flagToBound(entry.flag)) << 40 |
+               static_cast<uint64_t>(generation & 0x3f) << 42;
+    }
 };
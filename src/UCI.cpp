@@ -69,6 +69,7 @@ int main() {
     std::thread searchThread;
     std::string bestMove;
     bool pondering = false;
+    std::string hashFile;  // default path for save_hash / load_hash
 
     std::cout.setf(std::ios::unitbuf);
 
@@ -76,7 +77,16 @@ int main() {
         if (line == "uci") {
             std::cout << "id name Aphelion 1.1" << '\n';
             std::cout << "id author Matt LaDuke ChatGPT and Claude" << '\n';
+            std::cout << "option name Hash type spin default 32 min 1 max 65536" << '\n';
+            std::cout << "option name HashFile type string default <empty>" << '\n';
             std::cout << "option name OwnBook type check default false" << '\n';
+            std::cout << "option name Threads type spin default "
+                      << engine.getThreads() << " min 1 max "
+                      << engine.getMaxThreads() << '\n';
+            std::cout << "option name ReverseFutility type check default true" << '\n';
+            std::cout << "option name Futility type check default true" << '\n';
+            std::cout << "option name Razoring type check default true" << '\n';
+            std::cout << "option name LateMovePruning type check default true" << '\n';
             std::cout << "uciok" << '\n';
         } else if (line == "isready") {
             std::cout << "readyok" << '\n';
@@ -91,11 +101,28 @@ int main() {
                 if (name == "Hash" && valuePos != std::string::npos) {
                     int mb = std::stoi(line.substr(valuePos + 7));
                     engine.setHashSizeMB(static_cast<size_t>(mb));
+                } else if (name == "HashFile") {
+                    hashFile = valuePos == std::string::npos ? "" : line.substr(valuePos + 7);
+                    if (hashFile == "<empty>") hashFile.clear();
                 } else if (name == "OwnBook" && valuePos != std::string::npos) {
                     std::string val = line.substr(valuePos + 7);
                     for (auto &c : val) c = static_cast<char>(std::tolower(c));
                     bool enable = (val == "true" || val == "1");
                     engine.setOwnBook(enable);
+                } else if (name == "Threads" && valuePos != std::string::npos) {
+                    engine.setThreads(std::stoi(line.substr(valuePos + 7)));
+                } else if ((name == "ReverseFutility" || name == "Futility" ||
+                            name == "Razoring" || name == "LateMovePruning") &&
+                           valuePos != std::string::npos) {
+                    std::string val = line.substr(valuePos + 7);
+                    for (auto &c : val) c = static_cast<char>(std::tolower(c));
+                    bool enable = (val == "true" || val == "1");
+                    Engine::PruningOptions pruning = engine.getPruning();
+                    if (name == "ReverseFutility") pruning.reverseFutility = enable;
+                    else if (name == "Futility") pruning.futility = enable;
+                    else if (name == "Razoring") pruning.razoring = enable;
+                    else pruning.lateMovePruning = enable;
+                    engine.setPruning(pruning);
                 }
             }
         } else if (line == "ucinewgame") {
@@ -174,6 +201,48 @@ int main() {
                     std::cout << "bestmove " << uci << '\n';
                 }
             });
+        } else if (line.rfind("save_hash", 0) == 0 || line.rfind("load_hash", 0) == 0) {
+            if (searchThread.joinable()) {
+                stopFlag = true;
+                searchThread.join();
+            }
+            // An explicit path overrides the HashFile option
+            bool save = line[0] == 's';
+            std::string path = line.size() > 10 ? line.substr(10) : hashFile;
+            if (path.empty()) {
+                std::cout << "info string no hash file set" << '\n';
+            } else if (save ? engine.saveHash(path) : engine.loadHash(path)) {
+                std::cout << "info string hash " << (save ? "saved to " : "loaded from ")
+                          << path << '\n';
+            } else {
+                std::cout << "info string failed to " << (save ? "save hash to " : "load hash from ")
+                          << path << '\n';
+            }
+        } else if (line.rfind("bench", 0) == 0) {
+            if (searchThread.joinable()) {
+                stopFlag = true;
+                searchThread.join();
+            }
+            // Runs the bench positions without and with the TT prefetch and
+            // reports the difference in time stamp counter ticks per node
+            int depth = 5;
+            std::istringstream iss(line.substr(5));
+            iss >> depth;
+            bool prefetch = engine.isTTPrefetchEnabled();
+            double ticks[2] = {0.0, 0.0};
+            for (int enabled = 0; enabled < 2; ++enabled) {
+                engine.setTTPrefetch(enabled != 0);
+                Engine::BenchResult res = engine.bench(depth);
+                uint64_t nps = res.ms > 0 ? static_cast<uint64_t>(res.nodes * 1000 / res.ms) : res.nodes;
+                ticks[enabled] = res.ticksPerNode;
+                std::cout << "info string bench prefetch " << (enabled ? "on " : "off")
+                          << " nodes " << res.nodes << " time " << static_cast<int>(res.ms)
+                          << " nps " << nps << " ticks/node " << res.ticksPerNode
+                          << " re-searches " << res.failHighs + res.failLows << '\n';
+            }
+            std::cout << "info string bench prefetch saves "
+                      << ticks[0] - ticks[1] << " ticks/node" << '\n';
+            engine.setTTPrefetch(prefetch);
         } else if (line == "ponderhit") {
             if (searchThread.joinable() && pondering) {
                 stopFlag = true;
@@ -2,6 +2,8 @@
 // Zobrist hashing implementation for board state hashing.
 // -----------------------------------------------------------------------------
 #include "Zobrist.h"
+#include "BBCStyleEngine.h"
+#include "BitUtils.h"
 #include <random>
 
 namespace Zobrist {
@@ -22,6 +24,11 @@ namespace Zobrist {
         for (auto& v : enPassantHash) v = rng();
     }
 
+    // Boards maintain their key incrementally from the moment they are set up,
+    // so the keys are filled in during static initialization. init() uses a
+    // fixed seed and can still be called again without changing any key.
+    static const bool keysInitialized = (init(), true);
+
     // -------------------------------------------------------------------------
     // Computes the Zobrist hash for the given board position.
     // -------------------------------------------------------------------------
@@ -60,5 +67,25 @@ namespace Zobrist {
         if (ep != -1) h ^= enPassantHash[ep % 8];
         return h;
     }
-}
 
+    // -------------------------------------------------------------------------
+    // Computes the same hash for a BBC-style board. The piece order of the
+    // BBC bitboard array matches the pieceHashes layout, so positions hash
+    // identically on both representations.
+    // -------------------------------------------------------------------------
+    uint64_t hashBoard(const BBCStyleEngine& e) {
+        uint64_t h = 0;
+        for (int piece = 0; piece < 12; ++piece) {
+            uint64_t bb = e.bitboards[piece];
+            while (bb)
+                h ^= pieceHashes[piece][popLSBIndex(bb)];
+        }
+        if (e.side == white) h ^= sideHash;
+        if (e.castle & wk) h ^= castleHash[0];
+        if (e.castle & wq) h ^= castleHash[1];
+        if (e.castle & bk) h ^= castleHash[2];
+        if (e.castle & bq) h ^= castleHash[3];
+        if (e.enpassant != -1) h ^= enPassantHash[e.enpassant % 8];
+        return h;
+    }
+}
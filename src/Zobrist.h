@@ -3,6 +3,8 @@
 #include "Board.h"
 #include <array>
 
+class BBCStyleEngine;
+
 namespace Zobrist {
     extern std::array<std::array<uint64_t,64>,12> pieceHashes;
     extern uint64_t sideHash;
@@ -11,5 +13,6 @@ namespace Zobrist {
 
     void init();
     uint64_t hashBoard(const Board& b);
+    uint64_t hashBoard(const BBCStyleEngine& e);
 }
 
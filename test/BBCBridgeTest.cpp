@@ -0,0 +1,57 @@
+#include "BBCStyleEngine.h"
+#include "Board.h"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+// Loads a position both through the FEN parser and through the direct
+// Board bridge and checks that the two BBC-style boards are identical.
+static void checkPosition(const char* fen) {
+    Board board;
+    assert(board.loadFEN(fen));
+
+    BBCStyleEngine fromFen;
+    BBCStyleEngine fromBoard;
+    assert(fromFen.loadFromFEN(fen));
+    fromBoard.loadFromBoard(board);
+
+    assert(std::memcmp(fromFen.bitboards, fromBoard.bitboards,
+                       sizeof(fromFen.bitboards)) == 0);
+    assert(std::memcmp(fromFen.occupancies, fromBoard.occupancies,
+                       sizeof(fromFen.occupancies)) == 0);
+    assert(fromFen.side == fromBoard.side);
+    assert(fromFen.castle == fromBoard.castle);
+    assert(fromFen.enpassant == fromBoard.enpassant);
+}
+
+void testStartPosition() {
+    checkPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    std::cout << "[✔] Start position bridged\n";
+}
+
+void testKiwipete() {
+    checkPosition("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    std::cout << "[✔] Kiwipete bridged\n";
+}
+
+void testEnPassantAndPartialCastling() {
+    checkPosition("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w Kq f6 0 3");
+    checkPosition("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 0 1");
+    std::cout << "[✔] En passant and castling rights bridged\n";
+}
+
+void testMalformedFen() {
+    BBCStyleEngine engine;
+    assert(!engine.loadFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1"));
+    assert(!engine.loadFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+    std::cout << "[✔] Malformed FEN rejected\n";
+}
+
+int main() {
+    testStartPosition();
+    testKiwipete();
+    testEnPassantAndPartialCastling();
+    testMalformedFen();
+    std::cout << "\nBBC bridge tests passed!\n";
+    return 0;
+}
@@ -2,6 +2,11 @@
 #include "Zobrist.h"
 #include <cassert>
 #include <iostream>
+#include <type_traits>
+
+// The key history is a fixed array, so copying a Board never allocates
+static_assert(std::is_trivially_copyable<Board>::value,
+              "Board copies should be plain memory copies");
 
 void testFiftyMoveRule() {
     Board b;
@@ -32,9 +37,40 @@ void testThreefoldRepetition() {
     std::cout << "[✔] Threefold repetition detected\n";
 }
 
+void testRepetitionAfterLongShuffle() {
+    Board b;
+    b.loadFEN("4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    // Far more reversible moves than the key history holds
+    for (int i=0;i<100;i++) {
+        b.makeMove("e1-e2");
+        b.makeMove("e8-e7");
+        b.makeMove("e2-e1");
+        b.makeMove("e7-e8");
+    }
+    assert(b.getKeyHistorySize() <= Board::KEY_HISTORY_SIZE);
+    assert(b.isThreefoldRepetition());
+
+    // A pawn move is irreversible: earlier positions no longer count
+    b.loadFEN("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1");
+    b.makeMove("e1-d1");
+    b.makeMove("e8-d8");
+    b.makeMove("d1-e1");
+    b.makeMove("d8-e8");
+    assert(b.repetitionCount() == 2);
+    b.makeMove("e2-e3");
+    assert(b.repetitionCount() == 1);
+
+    Board::MoveState st;
+    b.makeMove("e8-d8", st);
+    b.unmakeMove(st);
+    assert(b.repetitionCount() == 1);
+    std::cout << "[✔] Repetitions tracked through a bounded key history\n";
+}
+
 int main(){
     Zobrist::init();
     testFiftyMoveRule();
     testThreefoldRepetition();
+    testRepetitionAfterLongShuffle();
     std::cout << "All tests done\n";
 }
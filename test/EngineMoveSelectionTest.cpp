@@ -1,5 +1,7 @@
 #include "Board.h"
 #include "Engine.h"
+#include "MoveEncoding.h"
+#include "SearchContext.h"
 #include <cassert>
 #include <iostream>
 
@@ -12,8 +14,34 @@ void testNoIllegalKa3() {
     std::cout << "Best move: " << best << "\n";
 }
 
+void testMateScoreAndPV() {
+    Engine engine;
+    Board board;
+    auto ctx = std::make_unique<SearchContext>();
+    std::atomic<bool> stop(false);
+    auto never = std::chrono::steady_clock::time_point::max();
+
+    // Back rank mate in one: the score counts plies to mate from the root
+    board.loadFEN("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+    ctx->setRoot(board);
+    int score = engine.negamax(*ctx, 3, -Engine::MATE, Engine::MATE, never, stop);
+    assert(score == Engine::MATE - 1);
+    std::cout << "Mate in one score: " << score << "\n";
+    assert(ctx->pvLength[0] >= 1 && decodeMove(ctx->pv[0][0]) == "d1-d8");
+
+    // The side to move is mated
+    board.loadFEN("3R2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 1 1");
+    ctx->setRoot(board);
+    score = engine.negamax(*ctx, 2, -Engine::MATE, Engine::MATE, never, stop);
+    assert(score == -Engine::MATE);
+    std::cout << "Mated score: " << score << "\n";
+    assert(ctx->pvLength[0] == 0);
+    std::cout << "[✔] Mate scores and principal variation\n";
+}
+
 int main() {
     testNoIllegalKa3();
+    testMateScoreAndPV();
     std::cout << "\nEngine move selection test passed!\n";
     return 0;
 }
@@ -0,0 +1,67 @@
+#include "Board.h"
+#include "MoveGenerator.h"
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+// Counts leaf nodes using pseudo-legal moves filtered by the pin and check
+// masks, computed once per node.
+static uint64_t perft(Board& board, const MoveGenerator& gen, int depth) {
+    if (depth == 0) return 1;
+    Board::LegalityInfo info = board.legalityInfo();
+    uint64_t nodes = 0;
+    for (uint16_t mv : gen.generateAllMoves(board, board.isWhiteToMove())) {
+        if (!board.isMoveLegal(mv, info)) continue;
+        Board::MoveState state;
+        board.makeMove(mv, state);
+        nodes += perft(board, gen, depth - 1);
+        board.unmakeMove(state);
+    }
+    return nodes;
+}
+
+static void checkPerft(const char* fen, int depth, uint64_t expected) {
+    Board board;
+    assert(board.loadFEN(fen));
+    MoveGenerator gen;
+    uint64_t nodes = perft(board, gen, depth);
+    assert(nodes == expected);
+}
+
+void testPerftPositions() {
+    // Kiwipete: pins, castling through attacks and en passant
+    checkPerft("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862);
+    // Horizontal en passant pins along the fifth rank
+    checkPerft("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238);
+    // Checks, double checks and promotions
+    checkPerft("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467);
+    checkPerft("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379);
+    std::cout << "[✔] Mask-based legality matches reference perft counts\n";
+}
+
+void testPinsAndChecks() {
+    Board b;
+    // Knight on e2 pinned by the rook on e8, bishop on c3 checking
+    b.loadFEN("4r1k1/8/8/8/8/2b5/4N3/4K3 w - - 0 1");
+    Board::LegalityInfo info = b.legalityInfo();
+    assert(info.kingSquare == 4);
+    assert(info.pinned == (1ULL << 12));
+    assert(info.checkers == (1ULL << 18));
+    assert(!b.isMoveLegal("e2-c3"));  // pinned piece may not capture off the line
+    assert(!b.isMoveLegal("e2-d4"));
+    assert(b.isMoveLegal("e1-f1"));
+    assert(!b.isMoveLegal("e1-d2"));  // still on the bishop's diagonal
+
+    // En passant that would expose the king along the rank
+    b.loadFEN("8/8/8/K2pP2r/8/8/8/7k w - d6 0 1");
+    assert(!b.isMoveLegal("e5-d6"));
+    b.loadFEN("8/8/8/K2pP3/8/8/8/7k w - d6 0 1");
+    assert(b.isMoveLegal("e5-d6"));
+    std::cout << "[✔] Pinned pieces and checkers detected\n";
+}
+
+int main() {
+    testPinsAndChecks();
+    testPerftPositions();
+    std::cout << "All tests done\n";
+}
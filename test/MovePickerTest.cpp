@@ -0,0 +1,176 @@
+#include "BBCStyleEngine.h"
+#include "MovePicker.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+static const char* const FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+};
+
+static std::vector<uint32_t> sorted(const BBCStyleEngine::MoveList& list) {
+    std::vector<uint32_t> moves;
+    for (int i = 0; i < list.count; ++i) moves.push_back(list.moves[i].data);
+    std::sort(moves.begin(), moves.end());
+    return moves;
+}
+
+void testStagedGeneration() {
+    for (const char* fen : FENS) {
+        BBCStyleEngine pos;
+        assert(pos.loadFromFEN(fen));
+        BBCStyleEngine::MoveList all, staged;
+        pos.generateMoves(all);
+        pos.generateCaptures(staged);
+        int captures = staged.count;
+        pos.generateQuiets(staged);
+        assert(sorted(all) == sorted(staged));
+        for (int i = 0; i < staged.count; ++i) {
+            assert(pos.isPseudoLegal(staged.moves[i]));
+            assert((i < captures) == (staged.moves[i].capture() ||
+                                      staged.moves[i].promoted() % 6 == Q));
+        }
+    }
+    std::cout << "[✔] Captures and quiets add up to all moves\n";
+}
+
+void testPseudoLegality() {
+    // Moves of one position are only accepted in another when they are
+    // generated there as well
+    for (const char* a : FENS) {
+        BBCStyleEngine from;
+        from.loadFromFEN(a);
+        BBCStyleEngine::MoveList candidates;
+        from.generateMoves(candidates);
+        for (const char* b : FENS) {
+            BBCStyleEngine pos;
+            pos.loadFromFEN(b);
+            std::vector<uint32_t> legal = sorted([&] {
+                BBCStyleEngine::MoveList l;
+                pos.generateMoves(l);
+                return l;
+            }());
+            for (int i = 0; i < candidates.count; ++i) {
+                bool generated = std::binary_search(legal.begin(), legal.end(),
+                                                    candidates.moves[i].data);
+                assert(pos.isPseudoLegal(candidates.moves[i]) == generated);
+            }
+        }
+    }
+    std::cout << "[✔] Pseudo-legality matches the generator\n";
+}
+
+void testPickerOrder() {
+    int history[64][64]{};
+    for (const char* fen : FENS) {
+        BBCStyleEngine pos;
+        pos.loadFromFEN(fen);
+        BBCStyleEngine::MoveList all;
+        pos.generateMoves(all);
+
+        // Try every move as the TT move with two quiet killers, plus moves
+        // that do not exist in this position
+        std::vector<uint16_t> hints = {0, 0x0fff, 0xc104};
+        for (int i = 0; i < all.count; ++i) hints.push_back(bbcMoveToUint16(all.moves[i]));
+        std::vector<uint16_t> quiets;
+        for (int i = 0; i < all.count; ++i)
+            if (!all.moves[i].capture()) quiets.push_back(bbcMoveToUint16(all.moves[i]));
+
+        for (uint16_t tt : hints) {
+            std::array<uint16_t, 2> killers = {
+                quiets.empty() ? uint16_t(0) : quiets.back(), 0x0fff};
+            BBCStyleEngine::MoveList buffer;
+            MovePicker picker(pos, buffer, tt, killers, history);
+            BBCStyleEngine::MoveList picked;
+            BBCStyleEngine::Move m;
+            while (picker.next(m))
+                picked.moves[picked.count++] = m;
+            assert(sorted(picked) == sorted(all));
+            if (std::find(hints.begin() + 3, hints.end(), tt) != hints.end())
+                assert(bbcMoveToUint16(picked.moves[0]) == tt);
+        }
+    }
+    std::cout << "[✔] Picker hands out every move exactly once\n";
+}
+
+void testCapturesBeforeQuiets() {
+    int history[64][64]{};
+    BBCStyleEngine pos;
+    pos.loadFromFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    history[4][6] = 7000;  // short castling
+    BBCStyleEngine::MoveList buffer;
+    std::array<uint16_t, 2> killers = {0, 0};
+    MovePicker picker(pos, buffer, 0, killers, history);
+    BBCStyleEngine::Move m;
+    std::vector<BBCStyleEngine::Move> order;
+    while (picker.next(m)) order.push_back(m);
+
+    size_t firstQuiet = 0;
+    while (firstQuiet < order.size() && order[firstQuiet].capture()) ++firstQuiet;
+    size_t firstBad = firstQuiet;
+    while (firstBad < order.size() && !order[firstBad].capture()) ++firstBad;
+    const int threshold = MovePicker::GOOD_CAPTURE_THRESHOLD;
+    for (size_t i = 0; i < firstQuiet; ++i)
+        assert(pos.seeGE(order[i], threshold));
+    for (size_t i = firstBad; i < order.size(); ++i)
+        assert(order[i].capture() && !pos.seeGE(order[i], threshold));
+    // Bishop takes bishop on a6 is the best MVV-LVA capture; queen takes the
+    // knight on f6 loses the queen to the bishop and only follows the quiets
+    assert(order[0].source() == 12 && order[0].target() == 40);
+    assert(order[firstBad].source() == 21 && order[firstBad].target() == 45);
+    // Highest history first among the quiets
+    assert(order[firstQuiet].castling());
+    std::cout << "[✔] Good captures, quiets by history, then losing captures\n";
+}
+
+void testQuiescencePicker() {
+    for (const char* fen : FENS) {
+        BBCStyleEngine pos;
+        pos.loadFromFEN(fen);
+        BBCStyleEngine::MoveList captures;
+        pos.generateCaptures(captures);
+        BBCStyleEngine::MoveList expected;
+        for (int i = 0; i < captures.count; ++i)
+            if (pos.seeGE(captures.moves[i], 0))
+                expected.moves[expected.count++] = captures.moves[i];
+
+        BBCStyleEngine::MoveList buffer;
+        MovePicker picker(pos, buffer, 0);
+        BBCStyleEngine::MoveList picked;
+        BBCStyleEngine::Move m;
+        while (picker.next(m))
+            picked.moves[picked.count++] = m;
+        assert(sorted(picked) == sorted(expected));
+
+        // A quiet TT move is left to the main search
+        BBCStyleEngine::MoveList quiets;
+        pos.generateQuiets(quiets);
+        if (quiets.count) {
+            MovePicker withQuiet(pos, buffer, bbcMoveToUint16(quiets.moves[0]));
+            picked.count = 0;
+            while (withQuiet.next(m))
+                picked.moves[picked.count++] = m;
+            assert(sorted(picked) == sorted(expected));
+        }
+    }
+    std::cout << "[✔] Quiescence picker hands out winning and even captures only\n";
+}
+
+int main() {
+    Zobrist::init();
+    testStagedGeneration();
+    testPseudoLegality();
+    testPickerOrder();
+    testCapturesBeforeQuiets();
+    testQuiescencePicker();
+    std::cout << "All tests done\n";
+}
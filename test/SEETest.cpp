@@ -0,0 +1,76 @@
+#include "BBCStyleEngine.h"
+#include "Zobrist.h"
+#include <cassert>
+#include <iostream>
+
+// Finds the generated move from source to target
+static BBCStyleEngine::Move findMove(const BBCStyleEngine& pos, int source, int target) {
+    BBCStyleEngine::MoveList list;
+    pos.generateMoves(list);
+    for (int i = 0; i < list.count; ++i)
+        if (list.moves[i].source() == source && list.moves[i].target() == target)
+            return list.moves[i];
+    assert(false && "move not generated");
+    return BBCStyleEngine::Move();
+}
+
+// The exchange is worth exactly `value`: at least value, but not value + 1
+static bool exchangeIs(const char* fen, int source, int target, int value) {
+    BBCStyleEngine pos;
+    pos.loadFromFEN(fen);
+    BBCStyleEngine::Move move = findMove(pos, source, target);
+    return pos.seeGE(move, value) && !pos.seeGE(move, value + 1);
+}
+
+void testSimpleExchanges() {
+    // Rook takes an undefended pawn
+    assert(exchangeIs("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", 4, 36, 100));
+    // Queen takes a pawn defended by a pawn
+    assert(exchangeIs("4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1", 4, 36, 100 - 1000));
+    // Pawn takes a defended knight
+    assert(exchangeIs("4k3/8/3p4/4n3/3P4/8/8/4K3 w - - 0 1", 27, 36, 300 - 100));
+    // En passant capture of an undefended pawn
+    assert(exchangeIs("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", 36, 43, 100));
+    std::cout << "[✔] Single captures\n";
+}
+
+void testXRays() {
+    // Nxe5 Nxe5 Rxe5 Bxe5 Qxe5 Qxe5: the queens behind the rook and the
+    // bishop join in, and White is best off after the first recapture
+    assert(exchangeIs("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+                      19, 36, -200));
+    // Doubled rooks win a pawn defended once
+    assert(exchangeIs("4k3/4r3/8/4p3/8/8/4R3/4R1K1 w - - 0 1", 12, 36, 100));
+    // Rxd5 cxd5 Rxd5: doubled rooks still lose the exchange to a pawn
+    assert(exchangeIs("4k3/8/2p5/3p4/8/8/3R4/3R2K1 w - - 0 1", 11, 35, -300));
+    std::cout << "[✔] X-ray attackers join the exchange\n";
+}
+
+void testKingCaptures() {
+    // The king may take a defended piece only when nothing recaptures
+    assert(exchangeIs("4k3/8/8/8/8/8/3p4/4K3 w - - 0 1", 4, 11, 100));
+    BBCStyleEngine pos;
+    pos.loadFromFEN("4k3/8/8/8/8/1n6/3p4/4K3 w - - 0 1");
+    // The knight guards d2, so Kxd2 cannot count on winning the pawn
+    BBCStyleEngine::Move kxd2 = findMove(pos, 4, 11);
+    assert(!pos.seeGE(kxd2, 1));
+    std::cout << "[✔] King captures only when safe\n";
+}
+
+void testPromotionsAndCastling() {
+    BBCStyleEngine pos;
+    pos.loadFromFEN("4k3/1P6/8/8/8/8/8/R3K2R w KQ - 0 1");
+    assert(pos.seeGE(findMove(pos, 49, 57), 0));
+    assert(!pos.seeGE(findMove(pos, 49, 57), 1));
+    assert(pos.seeGE(findMove(pos, 4, 6), 0));
+    std::cout << "[✔] Promotions and castling are even exchanges\n";
+}
+
+int main() {
+    Zobrist::init();
+    testSimpleExchanges();
+    testXRays();
+    testKingCaptures();
+    testPromotionsAndCastling();
+    std::cout << "All tests done\n";
+}
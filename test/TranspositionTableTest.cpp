@@ -0,0 +1,168 @@
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void testStoreAndProbe() {
+    TranspositionTable tt(1024);
+    TTEntry e{7, -135, 1, 0x1234};
+    tt.store(0x9abcdef012345678ULL, e);
+    TTEntry out{};
+    assert(tt.probe(0x9abcdef012345678ULL, out));
+    assert(out.depth == 7 && out.value == -135 && out.flag == 1 && out.move == 0x1234);
+    assert(!tt.probe(0x9abcdef012345679ULL, out));
+
+    // Mate scores survive the 16-bit score field
+    tt.store(42, TTEntry{3, 1000000, 0, 1});
+    assert(tt.probe(42, out) && out.value == 1000000 && out.flag == 0);
+    tt.store(43, TTEntry{3, -1000000, -1, 1});
+    assert(tt.probe(43, out) && out.value == -1000000 && out.flag == -1);
+    std::cout << "[✔] Packed entries round trip\n";
+}
+
+void testClusterReplacement() {
+    // A single cluster: every key lands in the same bucket
+    TranspositionTable tt(1);
+    for (uint64_t k = 1; k <= TranspositionTable::CLUSTER_SIZE; ++k)
+        tt.store(k, TTEntry{static_cast<int>(k) + 4, 0, 0, 0});
+    TTEntry out{};
+    for (uint64_t k = 1; k <= TranspositionTable::CLUSTER_SIZE; ++k)
+        assert(tt.probe(k, out));
+
+    // A full bucket evicts its shallowest entry
+    tt.store(100, TTEntry{9, 0, 0, 0});
+    assert(!tt.probe(1, out));
+    assert(tt.probe(100, out) && tt.probe(2, out));
+
+    // A shallower bound does not overwrite a deeper result for the same key,
+    // and a store without a move keeps the known one
+    tt.store(100, TTEntry{2, 50, 1, 0x77});
+    assert(tt.probe(100, out) && out.depth == 9);
+    tt.store(100, TTEntry{10, 60, 0, 0});
+    assert(tt.probe(100, out) && out.depth == 10 && out.value == 60);
+
+    tt.clear();
+    assert(!tt.probe(100, out) && tt.hashfull() == 0);
+    std::cout << "[✔] Bucket replacement prefers deep entries\n";
+}
+
+void testGenerations() {
+    TranspositionTable tt(1);
+    for (uint64_t k = 1; k <= TranspositionTable::CLUSTER_SIZE; ++k)
+        tt.store(k, TTEntry{20, 0, 0, 0});
+    assert(tt.hashfull() == 1000);
+
+    // Old entries are still found, but no longer count towards hashfull
+    tt.newSearch();
+    TTEntry out{};
+    assert(tt.probe(1, out) && out.depth == 20);
+    assert(tt.hashfull() == 0);
+
+    // A few searches later even a shallow entry replaces a deep stale one
+    tt.newSearch();
+    tt.newSearch();
+    tt.store(100, TTEntry{1, 0, 0, 0});
+    assert(tt.probe(100, out) && tt.hashfull() == 250);
+
+    // A stale entry for the same position is overwritten by a shallower one
+    tt.store(2, TTEntry{3, 5, 1, 0});
+    assert(tt.probe(2, out) && out.depth == 3 && out.value == 5);
+    std::cout << "[✔] Stale generations are replaced first\n";
+}
+
+void testHashfullSample() {
+    // One entry in each of the 2000 clusters; key i lands in cluster i
+    TranspositionTable tt(2000);
+    const uint64_t stride = UINT64_MAX / 2000 + 1;
+    for (uint64_t i = 0; i < 1000; ++i)
+        tt.store(stride * i + 12345, TTEntry{1, 0, 0, 0});
+    assert(tt.hashfull() == 250);
+
+    // Only the first 1000 clusters are sampled
+    for (uint64_t i = 1000; i < 2000; ++i)
+        tt.store(stride * i + 12345, TTEntry{1, 0, 0, 0});
+    assert(tt.hashfull() == 250);
+
+    tt.newSearch();
+    assert(tt.hashfull() == 0);
+    std::cout << "[✔] Hashfull sampled from the first clusters\n";
+}
+
+void testSnapshot() {
+    const char* path = "tt_snapshot_test.bin";
+    TranspositionTable saved(3000);
+    for (uint64_t k = 1; k <= 500; ++k)
+        saved.store(k * 0x9E3779B97F4A7C15ULL, TTEntry{static_cast<int>(k % 40), static_cast<int>(k), 1, static_cast<uint16_t>(k)});
+    assert(saved.save(path));
+
+    // Loading takes the snapshot's size and content
+    TranspositionTable loaded(16);
+    assert(loaded.load(path));
+    assert(loaded.size() == saved.size());
+    TTEntry out{};
+    for (uint64_t k = 1; k <= 500; ++k)
+        if (saved.probe(k * 0x9E3779B97F4A7C15ULL, out)) {
+            TTEntry copy{};
+            assert(loaded.probe(k * 0x9E3779B97F4A7C15ULL, copy));
+            assert(copy.depth == out.depth && copy.value == out.value && copy.move == out.move);
+        }
+    assert(loaded.hashfull() == saved.hashfull());
+
+    // The mapped table is writable and saving over its own file is safe
+    loaded.store(7, TTEntry{5, 9, 0, 3});
+    assert(loaded.save(path));
+    assert(loaded.probe(7, out) && out.value == 9);
+    TranspositionTable again(16);
+    assert(again.load(path) && again.probe(7, out) && out.depth == 5);
+
+    // A file that is not a snapshot leaves the table untouched
+    const char* junk = "tt_snapshot_junk.bin";
+    std::FILE* f = std::fopen(junk, "wb");
+    std::fputs("not a table", f);
+    std::fclose(f);
+    assert(!again.load(junk) && again.probe(7, out));
+    std::remove(junk);
+    assert(!again.load(junk));
+    std::remove(path);
+    std::cout << "[✔] Snapshots save and map back\n";
+}
+
+void testConcurrentStores() {
+    // Several writers hammer one cluster with entries whose contents are
+    // derived from their key; readers must never see a mixed entry.
+    TranspositionTable tt(1);
+    auto valueFor = [](uint64_t key) { return static_cast<int>(key % 20000); };
+    auto moveFor = [](uint64_t key) { return static_cast<uint16_t>(key >> 7); };
+    std::vector<std::thread> threads;
+    std::atomic<bool> mixed{false};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 1; i < 200000; ++i) {
+                uint64_t key = i * 0x9E3779B97F4A7C15ULL + t;
+                tt.store(key, TTEntry{static_cast<int>(i % 50), valueFor(key), 0, moveFor(key)});
+                TTEntry out{};
+                uint64_t probeKey = (i - 1) * 0x9E3779B97F4A7C15ULL + (t + 1) % 4;
+                if (tt.probe(probeKey, out) &&
+                    (out.value != valueFor(probeKey) || out.move != moveFor(probeKey)))
+                    mixed = true;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    assert(!mixed);
+    std::cout << "[✔] Racing stores never produce mixed entries\n";
+}
+
+int main() {
+    testStoreAndProbe();
+    testClusterReplacement();
+    testGenerations();
+    testHashfullSample();
+    testSnapshot();
+    testConcurrentStores();
+    std::cout << "All tests done\n";
+}
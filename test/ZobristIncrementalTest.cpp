@@ -0,0 +1,111 @@
+#include "BBCStyleEngine.h"
+#include "Board.h"
+#include "Zobrist.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Plays a sequence of moves on a Board and checks after every move that the
+// incrementally maintained key matches a full rehash, then unwinds the moves
+// and checks that every key is restored.
+static void playAndUnwind(const char* fen, const std::vector<std::string>& moves) {
+    Board board;
+    assert(board.loadFEN(fen));
+    assert(board.key() == Zobrist::hashBoard(board));
+
+    std::vector<Board::MoveState> states(moves.size());
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        keys.push_back(board.key());
+        board.makeMove(moves[i], states[i]);
+        assert(board.key() == Zobrist::hashBoard(board));
+    }
+    for (size_t i = moves.size(); i-- > 0;) {
+        board.unmakeMove(states[i]);
+        assert(board.key() == keys[i]);
+    }
+}
+
+void testBoardKeys() {
+    // Captures, castling on both wings and loss of castling rights
+    playAndUnwind("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                  {"O-O", "O-O-O", "e5-f7", "e7-f7", "d5-e6", "h3-g2"});
+    // Double push creating an en passant square, then the en passant capture
+    playAndUnwind("4k3/8/8/8/1p6/8/P7/4K3 w - - 0 1", {"a2-a4", "b4-a3"});
+    // Promotion with capture
+    playAndUnwind("1n2k3/P7/8/8/8/8/8/4K3 w - - 0 1", {"a7-b8q", "e8-d7"});
+    std::cout << "[✔] Board key matches full hash after every move\n";
+}
+
+void testSettersRefreshKey() {
+    Board board;
+    board.setWhiteToMove(false);
+    board.setEnPassantSquare(20);
+    board.setCastleWK(false);
+    board.setWhitePawns(board.getWhitePawns() & ~(1ULL << 12));
+    assert(board.key() == Zobrist::hashBoard(board));
+    std::cout << "[✔] Setters refresh the key\n";
+}
+
+// Walks every legal line to the given depth checking the BBC-style key.
+static void walk(BBCStyleEngine& engine, int depth) {
+    assert(engine.hashKey == Zobrist::hashBoard(engine));
+    if (depth == 0) return;
+    BBCStyleEngine::MoveList moves;
+    engine.generateMoves(moves);
+    for (int i = 0; i < moves.count; ++i) {
+        engine.copyBoard();
+        if (engine.makeMove(moves.moves[i]))
+            walk(engine, depth - 1);
+        engine.takeBack();
+    }
+}
+
+void testBBCKeys() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        assert(board.loadFEN(fen));
+        BBCStyleEngine engine;
+        engine.loadFromBoard(board);
+        assert(engine.hashKey == board.key());
+        walk(engine, 3);
+    }
+    std::cout << "[✔] BBC-style key matches full hash on every node\n";
+}
+
+void testNullMoveKeys() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 12 40",
+    };
+    for (const char* fen : fens) {
+        BBCStyleEngine engine;
+        assert(engine.loadFromFEN(fen));
+        BBCStyleEngine before = engine;
+        BBCStyleEngine::NullMoveState state = engine.makeNullMove();
+        assert(engine.side == (before.side ^ 1));
+        assert(engine.enpassant == -1);
+        assert(engine.hashKey == Zobrist::hashBoard(engine));
+        engine.unmakeNullMove(state);
+        assert(engine.side == before.side);
+        assert(engine.enpassant == before.enpassant);
+        assert(engine.fifty == before.fifty);
+        assert(engine.hashKey == before.hashKey);
+    }
+    std::cout << "[✔] Null move keeps the BBC-style key in step\n";
+}
+
+int main() {
+    testBoardKeys();
+    testSettersRefreshKey();
+    testBBCKeys();
+    testNullMoveKeys();
+    std::cout << "\nIncremental Zobrist tests passed!\n";
+    return 0;
+}